@@ -0,0 +1,52 @@
+-- ================================
+-- Clever_Tests (Executable)
+-- ================================
+
+project "Clever_Tests"
+    location "."
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++23"
+    staticruntime "on"
+
+    targetdir ("../../bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("../../bin-int/" .. outputdir .. "/%{prj.name}")
+
+    files 
+    { 
+        "src/**.h", 
+        "src/**.cpp" 
+    }
+
+    includedirs
+    {
+        "src",
+        "../src",
+        "../Vulkan/src",
+        "../Dependencies/glm/glm",
+        "../Dependencies/GLFW/include",
+        os.getenv("VULKAN_SDK") .. "/Include"
+    }
+
+    libdirs {
+        "../Dependencies/GLFW/lib-vc2022",
+        os.getenv("VULKAN_SDK") .. "/Lib",
+    }
+
+    links
+    {
+        "Clever_Engine",
+        "vulkan-1",
+        "Vulkan",
+        "glfw3"
+    }
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+        staticruntime "Off" -- /MDd
+
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "on"
+        staticruntime "Off" -- /MD
@@ -0,0 +1,98 @@
+#include "Test.h"
+
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <stdexcept>
+#include <thread>
+
+#include "Jobs/JobSystem.h"
+#include "World/ECS/Registry.h"
+
+namespace {
+	struct Position
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+	struct Velocity
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+}
+
+TEST(ParallelForRunsEveryIndexOnce)
+{
+	JobSystem jobSystem(3);
+	std::vector<std::atomic<uint32_t>> hits(10007);
+	jobSystem.ParallelFor(hits.size(), 64, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			hits[i].fetch_add(1);
+	});
+
+	bool allOnce = true;
+	for (const std::atomic<uint32_t>& hit : hits)
+		allOnce = allOnce && hit.load() == 1;
+	CHECK(allOnce);
+}
+
+TEST(NestedParallelForCompletes)
+{
+	JobSystem jobSystem(3);
+	std::atomic<uint32_t> total = 0;
+	jobSystem.ParallelFor(16, 1, [&](size_t, size_t)
+	{
+		jobSystem.ParallelFor(100, 10, [&](size_t begin, size_t end) { total.fetch_add(static_cast<uint32_t>(end - begin)); });
+	});
+	CHECK(total.load() == 1600);
+}
+
+TEST(ParallelForRethrowsJobExceptions)
+{
+	JobSystem jobSystem(3);
+	bool threw = false;
+	try
+	{
+		jobSystem.ParallelFor(100, 1, [](size_t begin, size_t)
+		{
+			if (begin == 42)
+				throw std::runtime_error("job failed");
+		});
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+//View::ParallelEach over 1M entities with 2, 4, 8, ... threads, ending on one per hardware thread
+BENCHMARK(JobSystemScaling)
+{
+	constexpr size_t EntityCount = 1000000;
+
+	Registry registry;
+	registry.CreateEntities(EntityCount, Position{}, Velocity{ 1.0f, 0.5f, 0.25f });
+	auto step = [](EntityID, Position& position, Velocity& velocity)
+	{
+		//Enough math per entity that memory bandwidth is not the only thing measured
+		float speed = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z);
+		position.x += velocity.x / speed + std::sin(position.y);
+		position.y += velocity.y / speed + std::cos(position.z);
+		position.z += velocity.z / speed;
+	};
+
+	double singleMs = Test::TimeMs([&] { registry.View<Position, Velocity>().Each(step); });
+	Test::Report("View::Each, 1 thread", singleMs);
+
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t threads = 2; threads < hardwareThreads * 2; threads *= 2)
+	{
+		threads = std::min(threads, hardwareThreads);
+		JobSystem jobSystem(threads - 1);
+		double ms = Test::TimeMs([&] { registry.View<Position, Velocity>().ParallelEach(jobSystem, step); });
+		std::string label = "View::ParallelEach, " + std::to_string(threads) + " threads";
+		Test::Report(label.c_str(), ms);
+		std::cout << "    speedup " << singleMs / ms << "x\n";
+	}
+}
@@ -0,0 +1,32 @@
+#include "Test.h"
+
+#include <string>
+#include <exception>
+
+//Runs every TEST, with --bench every BENCHMARK as well. Benchmark numbers only mean something in Release
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+	for (int i = 1; i < argc; ++i)
+		runBenchmarks = runBenchmarks || std::string(argv[i]) == "--bench";
+
+	for (const Test::Case& testCase : Test::Cases())
+	{
+		if (testCase.isBenchmark && !runBenchmarks)
+			continue;
+
+		std::cout << testCase.name << "\n";
+		try
+		{
+			testCase.function();
+		}
+		catch (const std::exception& exception)
+		{
+			++Test::failureCount;
+			std::cout << "  FAILED threw " << exception.what() << "\n";
+		}
+	}
+
+	std::cout << (Test::failureCount == 0 ? "All tests passed\n" : "Some tests failed\n");
+	return Test::failureCount == 0 ? 0 : 1;
+}
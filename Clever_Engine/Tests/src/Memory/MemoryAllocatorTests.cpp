@@ -0,0 +1,145 @@
+#include "Test.h"
+
+#include <vector>
+
+#include "Memory/MemoryAllocator.h"
+
+namespace {
+	struct Range
+	{
+		VkDeviceSize offset = 0;
+		VkDeviceSize reserved = 0;
+	};
+
+	Range MustAllocate(Vulkan::SubAllocator& allocator, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		Range range;
+		CHECK(allocator.Allocate(size, alignment, range.offset, range.reserved));
+		return range;
+	}
+
+	bool CanAllocate(Vulkan::SubAllocator& allocator, VkDeviceSize size, VkDeviceSize alignment)
+	{
+		Range range;
+		return allocator.Allocate(size, alignment, range.offset, range.reserved);
+	}
+}
+
+TEST(BuddySplitsAndMergesBackToOnePageBlock)
+{
+	Vulkan::BuddySubAllocator buddy(4096, 256);
+
+	//Splitting the page down to 256 leaves one free buddy at every order below it
+	Range first = MustAllocate(buddy, 200, 1);
+	CHECK(first.offset == 0 && first.reserved == 256);
+	CHECK(buddy.FreeBlockCount() == 4);
+	CHECK(buddy.LargestFreeBlock() == 2048);
+
+	Range second = MustAllocate(buddy, 256, 1);
+	Range third = MustAllocate(buddy, 1000, 1);
+	Range fourth = MustAllocate(buddy, 2048, 1);
+	CHECK(second.offset == 256 && third.offset == 1024 && third.reserved == 1024 && fourth.offset == 2048);
+	CHECK(buddy.UsedBytes() == 256 + 256 + 1024 + 2048);
+	CHECK(!CanAllocate(buddy, 1024, 1));
+
+	//Out of order, each free merges as far as its buddies allow
+	buddy.Free(third.offset, third.reserved);
+	buddy.Free(first.offset, first.reserved);
+	buddy.Free(fourth.offset, fourth.reserved);
+	buddy.Free(second.offset, second.reserved);
+	CHECK(buddy.UsedBytes() == 0);
+	CHECK(buddy.FreeBlockCount() == 1);
+	CHECK(buddy.LargestFreeBlock() == 4096);
+
+	Range whole = MustAllocate(buddy, 4096, 1);
+	CHECK(whole.offset == 0 && whole.reserved == 4096);
+}
+
+TEST(BuddyAlignmentLargerThanSizeGetsAnAlignedBlock)
+{
+	Vulkan::BuddySubAllocator buddy(65536, 256);
+	MustAllocate(buddy, 100, 1);
+
+	Range aligned = MustAllocate(buddy, 16, 4096);
+	CHECK(aligned.offset % 4096 == 0 && aligned.offset != 0);
+	CHECK(aligned.reserved == 4096);
+
+	//No block of the page can be aligned to more than the page itself
+	CHECK(!CanAllocate(buddy, 16, 131072));
+}
+
+TEST(PoolRejectsOversizeAndMisalignedRequests)
+{
+	Vulkan::PoolSubAllocator pool(1024, 256);
+
+	CHECK(!CanAllocate(pool, 257, 1));
+	//Blocks start at multiples of 256, so only alignments dividing it can be promised
+	CHECK(!CanAllocate(pool, 64, 512));
+	CHECK(pool.FreeBlockCount() == 4);
+
+	std::vector<Range> blocks;
+	for (int i = 0; i < 4; ++i)
+		blocks.push_back(MustAllocate(pool, 64, 128));
+	for (size_t i = 0; i < blocks.size(); ++i)
+		CHECK(blocks[i].offset == i * 256 && blocks[i].reserved == 256);
+	CHECK(!CanAllocate(pool, 64, 1));
+
+	pool.Free(blocks[2].offset, blocks[2].reserved);
+	CHECK(MustAllocate(pool, 256, 256).offset == 512);
+}
+
+TEST(LinearResetsAfterTheLastFree)
+{
+	Vulkan::LinearSubAllocator linear(1024);
+
+	Range first = MustAllocate(linear, 100, 1);
+	//The padding up to the alignment is charged to the allocation
+	Range second = MustAllocate(linear, 10, 64);
+	CHECK(first.offset == 0);
+	CHECK(second.offset == 128 && second.reserved == 38);
+	CHECK(linear.UsedBytes() == 138);
+	CHECK(!CanAllocate(linear, 1024 - 138 + 1, 1));
+
+	//Nothing comes back while any allocation is still live
+	linear.Free(first.offset, first.reserved);
+	CHECK(linear.UsedBytes() == 138);
+	linear.Free(second.offset, second.reserved);
+	CHECK(linear.UsedBytes() == 0);
+	CHECK(linear.LargestFreeBlock() == 1024);
+	CHECK(MustAllocate(linear, 1024, 1).offset == 0);
+
+	linear.Reset();
+	CHECK(linear.UsedBytes() == 0 && linear.FreeBlockCount() == 1);
+}
+
+TEST(FreeBlockStatsFollowFragmentation)
+{
+	Vulkan::BuddySubAllocator buddy(4096, 256);
+	std::vector<Range> blocks;
+	for (int i = 0; i < 16; ++i)
+		blocks.push_back(MustAllocate(buddy, 256, 1));
+	CHECK(buddy.FreeBlockCount() == 0 && buddy.LargestFreeBlock() == 0);
+
+	//Every other block, so no two free blocks are buddies
+	for (size_t i = 0; i < blocks.size(); i += 2)
+		buddy.Free(blocks[i].offset, blocks[i].reserved);
+	CHECK(buddy.FreeBlockCount() == 8);
+	CHECK(buddy.LargestFreeBlock() == 256);
+	CHECK(!CanAllocate(buddy, 512, 1));
+
+	Vulkan::MemoryStats stats;
+	stats.reservedBytes = 4096;
+	stats.usedBytes = buddy.UsedBytes();
+	stats.largestFreeBlock = buddy.LargestFreeBlock();
+	stats.freeBlockCount = buddy.FreeBlockCount();
+	CHECK(stats.usedBytes == 2048);
+	CHECK(stats.Fragmentation() == 1.0f - 256.0f / 2048.0f);
+
+	for (size_t i = 1; i < blocks.size(); i += 2)
+		buddy.Free(blocks[i].offset, blocks[i].reserved);
+	stats.usedBytes = buddy.UsedBytes();
+	stats.largestFreeBlock = buddy.LargestFreeBlock();
+	stats.freeBlockCount = buddy.FreeBlockCount();
+	CHECK(stats.freeBlockCount == 1 && stats.largestFreeBlock == 4096);
+	CHECK(stats.Fragmentation() == 0.0f);
+}
@@ -0,0 +1,253 @@
+#include "Test.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <random>
+#include <gtc/matrix_transform.hpp>
+
+#include "Context/ContextVulkanData.h"
+#include "Memory/MemoryAllocator.h"
+#include "Buffers/CreateBuffer.h"
+#include "Scene/CreateDescriptors.h"
+#include "Scene/CreatePipelines.h"
+#include "Scene/FrustumCull.h"
+
+namespace {
+	//Compute only device without a window or surface, a CPU device like lavapipe is preferred so the result does not depend on the GPU
+	std::shared_ptr<Vulkan::VulkanCore> CreateHeadlessCore()
+	{
+		VkApplicationInfo appInfo{};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Clever_Tests";
+		appInfo.apiVersion = VK_API_VERSION_1_0;
+
+		VkInstanceCreateInfo instanceInfo{};
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+
+		auto core = std::make_shared<Vulkan::VulkanCore>();
+		if (vkCreateInstance(&instanceInfo, nullptr, &core->vkInstance) != VK_SUCCESS)
+			return nullptr;
+
+		uint32_t deviceCount = 0;
+		vkEnumeratePhysicalDevices(core->vkInstance, &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(core->vkInstance, &deviceCount, devices.data());
+
+		uint32_t queueFamily = UINT32_MAX;
+		for (VkPhysicalDevice device : devices)
+		{
+			uint32_t familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+
+			VkPhysicalDeviceProperties properties{};
+			vkGetPhysicalDeviceProperties(device, &properties);
+			for (uint32_t family = 0; family < familyCount; ++family)
+			{
+				if ((families[family].queueFlags & VK_QUEUE_COMPUTE_BIT) == 0)
+					continue;
+				if (core->vkPhysicalDevice == VK_NULL_HANDLE || properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+				{
+					core->vkPhysicalDevice = device;
+					queueFamily = family;
+				}
+				break;
+			}
+		}
+		if (core->vkPhysicalDevice == VK_NULL_HANDLE)
+		{
+			vkDestroyInstance(core->vkInstance, nullptr);
+			return nullptr;
+		}
+
+		float priority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo{};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamily;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &priority;
+
+		VkDeviceCreateInfo deviceInfo{};
+		deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.queueCreateInfoCount = 1;
+		deviceInfo.pQueueCreateInfos = &queueInfo;
+		if (vkCreateDevice(core->vkPhysicalDevice, &deviceInfo, nullptr, &core->vkDevice) != VK_SUCCESS)
+		{
+			vkDestroyInstance(core->vkInstance, nullptr);
+			return nullptr;
+		}
+
+		//The engine's helpers submit to graphicsQueue out of coreCommandPool
+		core->d_PhysicalDeviceData.graphicsIndex = queueFamily;
+		vkGetDeviceQueue(core->vkDevice, queueFamily, 0, &core->graphicsQueue);
+		core->presentQueue = core->graphicsQueue;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		vkCreateCommandPool(core->vkDevice, &poolInfo, nullptr, &core->coreCommandPool);
+
+		core->memoryAllocator = std::make_shared<Vulkan::MemoryAllocator>(core->vkDevice, core->vkPhysicalDevice);
+		return core;
+	}
+
+	void DestroyHeadlessCore(std::shared_ptr<Vulkan::VulkanCore>& core)
+	{
+		core->memoryAllocator.reset();
+		vkDestroyCommandPool(core->vkDevice, core->coreCommandPool, nullptr);
+		vkDestroyDevice(core->vkDevice, nullptr);
+		vkDestroyInstance(core->vkInstance, nullptr);
+		core.reset();
+	}
+
+	VkDescriptorBufferInfo WholeBuffer(const Vulkan::VulkanBuffer& buffer)
+	{
+		VkDescriptorBufferInfo info{};
+		info.buffer = buffer.buffer;
+		info.offset = 0;
+		info.range = VK_WHOLE_SIZE;
+		return info;
+	}
+}
+
+//Runs res/cull.spv over a few groups of instances and compares every group's visible set and draw count with Vulkan::IsInstanceVisible
+TEST(CullShaderMatchesFrustumCull)
+{
+	//Built next to its source by the Vulkan project's prebuild step
+	std::filesystem::path shaderPath = std::filesystem::path(__FILE__).parent_path() / "../../../Vulkan/res/cull.spv";
+	if (!std::filesystem::exists(shaderPath))
+	{
+		std::cout << "  skipped, no cull.spv\n";
+		return;
+	}
+	std::shared_ptr<Vulkan::VulkanCore> core = CreateHeadlessCore();
+	if (!core)
+	{
+		std::cout << "  skipped, no Vulkan device\n";
+		return;
+	}
+
+	//The last group's mesh has no vertices, the shader leaves it empty like Window::PrepareCulling expects
+	std::vector<Vulkan::InstanceGroup> groups = { { 0, 0, 400 }, { 1, 400, 500 }, { 2, 900, 100 } };
+	std::vector<glm::vec4> meshBounds = { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.5f, -0.5f, 0.0f, 2.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) };
+	std::vector<VkDrawIndirectCommand> drawCommands(groups.size());
+	for (size_t i = 0; i < groups.size(); ++i)
+	{
+		drawCommands[i].vertexCount = groups[i].meshID == 2 ? 0 : 3;
+		drawCommands[i].firstInstance = groups[i].firstInstance;
+	}
+	constexpr uint32_t InstanceCount = 1000;
+
+	glm::mat4 viewProjection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::array<glm::vec4, 6> planes = Vulkan::ExtractFrustumPlanes(viewProjection);
+
+	//Spheres that sit right on a plane can round either way on the GPU, those are drawn again
+	std::mt19937 gen(7);
+	std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 3.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+	std::vector<glm::mat4> models(InstanceCount);
+	std::vector<std::vector<uint32_t>> expected(groups.size());
+	for (size_t group = 0; group < groups.size(); ++group)
+	{
+		glm::vec4 bounds = meshBounds[groups[group].meshID];
+		for (uint32_t instance = groups[group].firstInstance; instance < groups[group].firstInstance + groups[group].instanceCount; ++instance)
+		{
+			bool visible = false;
+			while (true)
+			{
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(gen), position(gen), position(gen)));
+				model = glm::rotate(model, angle(gen), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+				models[instance] = glm::scale(model, glm::vec3(scale(gen), scale(gen), scale(gen)));
+
+				visible = Vulkan::IsInstanceVisible(planes, models[instance], glm::vec4(glm::vec3(bounds), bounds.w * 1.001f));
+				if (visible == Vulkan::IsInstanceVisible(planes, models[instance], glm::vec4(glm::vec3(bounds), bounds.w * 0.999f)))
+					break;
+			}
+			if (visible && drawCommands[group].vertexCount != 0)
+				expected[group].push_back(instance);
+		}
+	}
+	CHECK(!expected[0].empty() && !expected[1].empty());
+	CHECK(expected[0].size() < groups[0].instanceCount);
+
+	Vulkan::VulkanBuffer modelBuffer = Vulkan::CreateMappedStorageBuffer(core, sizeof(glm::mat4) * InstanceCount);
+	Vulkan::VulkanBuffer visibleBuffer = Vulkan::CreateMappedStorageBuffer(core, sizeof(uint32_t) * InstanceCount);
+	Vulkan::VulkanBuffer boundsBuffer = Vulkan::CreateMappedStorageBuffer(core, sizeof(glm::vec4) * meshBounds.size());
+	Vulkan::VulkanBuffer groupBuffer = Vulkan::CreateMappedStorageBuffer(core, sizeof(Vulkan::InstanceGroup) * groups.size());
+	Vulkan::VulkanBuffer commandBuffer = Vulkan::CreateMappedStorageBuffer(core, sizeof(VkDrawIndirectCommand) * drawCommands.size(), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	memcpy(modelBuffer.mapped, models.data(), sizeof(glm::mat4) * InstanceCount);
+	memset(visibleBuffer.mapped, 0xFF, sizeof(uint32_t) * InstanceCount);
+	memcpy(boundsBuffer.mapped, meshBounds.data(), sizeof(glm::vec4) * meshBounds.size());
+	memcpy(groupBuffer.mapped, groups.data(), sizeof(Vulkan::InstanceGroup) * groups.size());
+	memcpy(commandBuffer.mapped, drawCommands.data(), sizeof(VkDrawIndirectCommand) * drawCommands.size());
+
+	//Same set layout and push constants as VulkanSurface::CreateInstanceResources
+	Vulkan::DescriptorSetInfo setInfo{};
+	setInfo.maxSets = 1;
+	setInfo.bindings.push_back({ Vulkan::ModelMatrixBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+	setInfo.bindings.push_back({ Vulkan::VisibleInstanceBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+	setInfo.bindings.push_back({ Vulkan::MeshBoundsBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+	setInfo.bindings.push_back({ Vulkan::InstanceGroupBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+	setInfo.bindings.push_back({ Vulkan::DrawCommandBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+	setInfo.bindings[Vulkan::ModelMatrixBinding].buffers.push_back(WholeBuffer(modelBuffer));
+	setInfo.bindings[Vulkan::VisibleInstanceBinding].buffers.push_back(WholeBuffer(visibleBuffer));
+	setInfo.bindings[Vulkan::MeshBoundsBinding].buffers.push_back(WholeBuffer(boundsBuffer));
+	setInfo.bindings[Vulkan::InstanceGroupBinding].buffers.push_back(WholeBuffer(groupBuffer));
+	setInfo.bindings[Vulkan::DrawCommandBinding].buffers.push_back(WholeBuffer(commandBuffer));
+	Vulkan::DescriptorResult descriptors = Vulkan::CreateDescriptors(core, setInfo);
+
+	Vulkan::PipelineLayoutInfo layoutInfo{};
+	layoutInfo.setLayouts.push_back(descriptors.layout);
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(Vulkan::CullPushConstants);
+	layoutInfo.pushConstants.push_back(pushConstantRange);
+	VkPipelineLayout pipelineLayout = Vulkan::CreatePipelineLayout(core, layoutInfo);
+	VkPipeline pipeline = Vulkan::CreateComputePipeline(core, shaderPath.string(), pipelineLayout);
+
+	Vulkan::CullPushConstants constants{};
+	constants.viewProjection = viewProjection;
+	constants.instanceCount = InstanceCount;
+	constants.groupCount = static_cast<uint32_t>(groups.size());
+
+	VkCommandBuffer cmd = Vulkan::BeginSingleTimeCommands(core);
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptors.sets[0], 0, nullptr);
+	vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Vulkan::CullPushConstants), &constants);
+	vkCmdDispatch(cmd, (InstanceCount + 63) / 64, 1, 1);
+
+	VkMemoryBarrier readBack{};
+	readBack.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readBack.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	readBack.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readBack, 0, nullptr, 0, nullptr);
+	Vulkan::EndSingleTimeCommands(core, cmd);
+
+	//Slots within a group are filled in whatever order the invocations ran
+	const VkDrawIndirectCommand* results = static_cast<const VkDrawIndirectCommand*>(commandBuffer.mapped);
+	const uint32_t* visibleInstances = static_cast<const uint32_t*>(visibleBuffer.mapped);
+	for (size_t group = 0; group < groups.size(); ++group)
+	{
+		CHECK(results[group].instanceCount == expected[group].size());
+		uint32_t count = std::min(results[group].instanceCount, groups[group].instanceCount);
+		std::vector<uint32_t> visible(visibleInstances + groups[group].firstInstance, visibleInstances + groups[group].firstInstance + count);
+		std::sort(visible.begin(), visible.end());
+		CHECK(visible == expected[group]);
+	}
+
+	vkDestroyPipeline(core->vkDevice, pipeline, nullptr);
+	vkDestroyPipelineLayout(core->vkDevice, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(core->vkDevice, descriptors.pool, nullptr);
+	vkDestroyDescriptorSetLayout(core->vkDevice, descriptors.layout, nullptr);
+	for (Vulkan::VulkanBuffer* buffer : { &modelBuffer, &visibleBuffer, &boundsBuffer, &groupBuffer, &commandBuffer })
+		Vulkan::DestroyBuffer(core, *buffer);
+	DestroyHeadlessCore(core);
+}
@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include <cmath>
+#include <random>
+#include <gtc/matrix_transform.hpp>
+
+#include "Scene/FrustumCull.h"
+
+namespace {
+	glm::mat4 Translation(float x, float y, float z)
+	{
+		return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+	}
+
+	//A 20 unit box around the origin, x and y from -10 to 10 and z from -10 to 10 with the camera looking down -z
+	glm::mat4 BoxViewProjection()
+	{
+		return glm::orthoRH_ZO(-10.0f, 10.0f, -10.0f, 10.0f, -10.0f, 10.0f);
+	}
+}
+
+//A point is a zero radius sphere, the planes must agree with the clip space test the rasterizer uses
+TEST(FrustumPlanesMatchClipSpaceForPoints)
+{
+	glm::mat4 viewProjection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::array<glm::vec4, 6> planes = Vulkan::ExtractFrustumPlanes(viewProjection);
+
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+	size_t visibleCount = 0, checkedCount = 0;
+	for (int i = 0; i < 20000; ++i)
+	{
+		glm::vec3 point(coordinate(gen), coordinate(gen), coordinate(gen));
+		glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+
+		//Points right on a plane can round either way
+		float margin = std::min({ clip.w - clip.x, clip.w + clip.x, clip.w - clip.y, clip.w + clip.y, clip.z, clip.w - clip.z });
+		if (std::abs(margin) < 1e-3f)
+			continue;
+
+		bool inside = margin > 0.0f;
+		CHECK(Vulkan::IsInstanceVisible(planes, Translation(point.x, point.y, point.z), glm::vec4(0.0f)) == inside);
+		visibleCount += inside;
+		++checkedCount;
+	}
+	//Both outcomes were actually exercised
+	CHECK(visibleCount > 100 && checkedCount - visibleCount > 100);
+}
+
+TEST(SpheresStraddlingAPlaneAreVisible)
+{
+	std::array<glm::vec4, 6> planes = Vulkan::ExtractFrustumPlanes(BoxViewProjection());
+	glm::vec4 unitSphere(0.0f, 0.0f, 0.0f, 1.0f);
+
+	//Centers half a unit outside each side plane
+	CHECK(Vulkan::IsInstanceVisible(planes, Translation(10.5f, 0.0f, 0.0f), unitSphere));
+	CHECK(Vulkan::IsInstanceVisible(planes, Translation(0.0f, -10.5f, 0.0f), unitSphere));
+	CHECK(!Vulkan::IsInstanceVisible(planes, Translation(11.5f, 0.0f, 0.0f), unitSphere));
+	CHECK(!Vulkan::IsInstanceVisible(planes, Translation(0.0f, -11.5f, 0.0f), unitSphere));
+
+	//Near plane at z 10 and far plane at z -10
+	CHECK(Vulkan::IsInstanceVisible(planes, Translation(0.0f, 0.0f, 10.5f), unitSphere));
+	CHECK(!Vulkan::IsInstanceVisible(planes, Translation(0.0f, 0.0f, 11.5f), unitSphere));
+	CHECK(Vulkan::IsInstanceVisible(planes, Translation(0.0f, 0.0f, -10.5f), unitSphere));
+	CHECK(!Vulkan::IsInstanceVisible(planes, Translation(0.0f, 0.0f, -11.5f), unitSphere));
+}
+
+TEST(ModelScaleAndOffsetBoundsAreApplied)
+{
+	std::array<glm::vec4, 6> planes = Vulkan::ExtractFrustumPlanes(BoxViewProjection());
+	glm::mat4 outside = Translation(12.0f, 0.0f, 0.0f);
+
+	CHECK(!Vulkan::IsInstanceVisible(planes, outside, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	//The largest axis scale grows the radius, whichever axis it is on
+	CHECK(Vulkan::IsInstanceVisible(planes, glm::scale(outside, glm::vec3(3.0f, 1.0f, 1.0f)), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	CHECK(Vulkan::IsInstanceVisible(planes, glm::scale(outside, glm::vec3(1.0f, 1.0f, 3.0f)), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	//A sphere centered off the mesh origin moves with the model
+	CHECK(Vulkan::IsInstanceVisible(planes, outside, glm::vec4(-2.5f, 0.0f, 0.0f, 1.0f)));
+	CHECK(!Vulkan::IsInstanceVisible(planes, glm::scale(outside, glm::vec3(0.5f)), glm::vec4(-2.5f, 0.0f, 0.0f, 1.0f)));
+}
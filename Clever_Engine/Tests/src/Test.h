@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+/*
+Just enough of a test runner for the engine. TEST and BENCHMARK bodies register themselves before main,
+CHECK reports a failure and carries on with the rest of the test.
+Benchmarks only run when the runner is started with --bench, they print their own timings with TimeMs.
+*/
+namespace Test {
+
+	struct Case
+	{
+		const char* name;
+		void (*function)();
+		bool isBenchmark;
+	};
+
+	inline std::vector<Case>& Cases()
+	{
+		static std::vector<Case> cases;
+		return cases;
+	}
+
+	inline int failureCount = 0;
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*function)(), bool isBenchmark) { Cases().push_back({ name, function, isBenchmark }); }
+	};
+
+	inline void Fail(const char* expression, const char* file, int line)
+	{
+		++failureCount;
+		std::cout << "  FAILED " << expression << " (" << file << ":" << line << ")\n";
+	}
+
+	//Best of repeats runs of func in milliseconds, the first runs tend to pay for cold caches and page faults
+	template<typename Func>
+	double TimeMs(Func&& func, int repeats = 5)
+	{
+		double best = 0.0;
+		for (int i = 0; i < repeats; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i == 0 ? ms : std::min(best, ms);
+		}
+		return best;
+	}
+
+	inline void Report(const char* label, double ms)
+	{
+		std::cout << "  " << label << ": " << ms << " ms\n";
+	}
+}
+
+#define TEST(name) \
+	static void name(); \
+	static Test::Registrar name##Registrar(#name, name, false); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static Test::Registrar name##Registrar(#name, name, true); \
+	static void name()
+
+#define CHECK(expression) ((expression) ? void(0) : Test::Fail(#expression, __FILE__, __LINE__))
@@ -0,0 +1,73 @@
+#include "Test.h"
+
+#include <algorithm>
+
+#include "World/ECS/Registry.h"
+
+namespace {
+	struct Position
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+}
+
+TEST(ParallelMarkChangedLogsEveryEntityOnce)
+{
+	constexpr size_t EntityCount = 20000;
+
+	Registry registry;
+	std::vector<EntityID> entities = registry.CreateEntities(EntityCount, Position{});
+	registry.AdvanceTick();
+	ChangeTick sinceTick = registry.GetTick() - 1;
+
+	JobSystem jobSystem(3);
+	ComponentStorage<Position>& positions = registry.GetAllComponents<Position>();
+	jobSystem.ParallelFor(EntityCount, 256, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			//The second mark in the same tick must not log again
+			positions.MarkChanged(entities[i]);
+			positions.MarkChanged(entities[i]);
+		}
+	});
+
+	std::vector<EntityID> changed;
+	registry.Changed<Position>(sinceTick).Each([&](EntityID entity, Position&) { changed.push_back(entity); });
+	std::sort(changed.begin(), changed.end());
+	std::sort(entities.begin(), entities.end());
+	CHECK(changed == entities);
+	CHECK(positions.GetChangeLog().size() - positions.FirstChangeSince(sinceTick) == EntityCount);
+}
+
+TEST(ChangedOnlyVisitsEntitiesChangedSinceTick)
+{
+	Registry registry;
+	std::vector<EntityID> entities = registry.CreateEntities(10, Position{});
+	registry.AdvanceTick();
+	ChangeTick sinceTick = registry.GetTick() - 1;
+	registry.Patch<Position>(entities[3]).x = 1.0f;
+	registry.MarkChanged<Position>(entities[7]);
+
+	std::vector<EntityID> changed;
+	registry.Changed<Position>(sinceTick).Each([&](EntityID entity, Position&) { changed.push_back(entity); });
+	CHECK(changed.size() == 2);
+	CHECK(std::find(changed.begin(), changed.end(), entities[3]) != changed.end());
+	CHECK(std::find(changed.begin(), changed.end(), entities[7]) != changed.end());
+}
+
+TEST(ChangedScansWhenHistoryIsForgotten)
+{
+	Registry registry;
+	registry.SetChangeHistory(2);
+	std::vector<EntityID> entities = registry.CreateEntities(10, Position{});
+	registry.AdvanceTick();
+	ChangeTick sinceTick = registry.GetTick() - 1;
+	registry.MarkChanged<Position>(entities[5]);
+	for (int i = 0; i < 5; ++i)
+		registry.AdvanceTick();
+
+	std::vector<EntityID> changed;
+	registry.Changed<Position>(sinceTick).Each([&](EntityID entity, Position&) { changed.push_back(entity); });
+	CHECK(changed.size() == 1 && changed[0] == entities[5]);
+}
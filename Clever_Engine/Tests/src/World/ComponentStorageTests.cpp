@@ -0,0 +1,72 @@
+#include "Test.h"
+
+#include <unordered_map>
+
+#include "World/ECS/Registry.h"
+
+namespace {
+	struct Position
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+}
+
+TEST(SparseSetSwapRemoveKeepsOtherEntities)
+{
+	ComponentStorage<Position> storage;
+	EntityID a = MakeEntityID(1, 0), b = MakeEntityID(2, 0), c = MakeEntityID(3, 0);
+	storage.Set(a, { 1.0f });
+	storage.Set(b, { 2.0f });
+	storage.Set(c, { 3.0f });
+
+	storage.Remove(a);
+
+	CHECK(!storage.Has(a));
+	CHECK(storage.size() == 2);
+	CHECK(storage.Get(b).x == 2.0f);
+	CHECK(storage.Get(c).x == 3.0f);
+}
+
+TEST(SparseSetIgnoresStaleHandles)
+{
+	ComponentStorage<Position> storage;
+	EntityID current = MakeEntityID(5, 1);
+	storage.Set(current, { 1.0f });
+
+	CHECK(storage.Has(current));
+	CHECK(!storage.Has(MakeEntityID(5, 0)));
+	storage.Remove(MakeEntityID(5, 0));
+	CHECK(storage.Has(current));
+}
+
+//Against the layout ComponentStorage replaced, one hash map node per component. The sums are whole numbers so order does not matter
+BENCHMARK(SparseSetIterationVsUnorderedMap)
+{
+	constexpr uint32_t EntityCount = 100000;
+
+	ComponentStorage<Position> storage;
+	std::unordered_map<EntityID, Position> map;
+	for (uint32_t i = 1; i <= EntityCount; ++i)
+	{
+		storage.Set(MakeEntityID(i, 0), { static_cast<float>(i) });
+		map.insert({ MakeEntityID(i, 0), { static_cast<float>(i) } });
+	}
+
+	double sparseSum = 0.0, mapSum = 0.0;
+	double sparseMs = Test::TimeMs([&]
+	{
+		sparseSum = 0.0;
+		for (auto [entity, position] : storage)
+			sparseSum += position.x;
+	});
+	double mapMs = Test::TimeMs([&]
+	{
+		mapSum = 0.0;
+		for (auto& [entity, position] : map)
+			mapSum += position.x;
+	});
+
+	CHECK(sparseSum == mapSum);
+	Test::Report("sparse set, 100k", sparseMs);
+	Test::Report("unordered_map, 100k", mapMs);
+}
@@ -0,0 +1,63 @@
+#include "Test.h"
+
+#include <stdexcept>
+
+#include "World/ECS/EntityCommandBuffer.h"
+
+namespace {
+	struct Position
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+	struct Health
+	{
+		int value = 100;
+	};
+}
+
+TEST(PlaybackSkipsCommandsForEntitiesDestroyedEarlier)
+{
+	Registry registry;
+	EntityCommandBuffer commands;
+	EntityID existing = registry.CreateEntity();
+	DeferredEntity deferred = commands.CreateEntity();
+
+	commands.DestroyEntity(existing);
+	commands.AddComponent(existing, Position{});
+	commands.DestroyEntity(deferred);
+	commands.AddComponent(deferred, Position{});
+	commands.RemoveComponent<Position>(deferred);
+	commands.Playback(registry);
+
+	CHECK(!registry.IsAlive(existing));
+	CHECK(registry.GetAliveCount() == 0);
+	CHECK(registry.GetAllComponents<Position>().size() == 0);
+}
+
+TEST(PlaybackClearsTheBufferWhenACommandThrows)
+{
+	Registry registry;
+	EntityCommandBuffer commands;
+	//Archetype entities cannot gain components, so adding Health throws during playback
+	EntityID archetypeEntity = registry.CreateEntity(StoragePolicy::Archetype, Position{});
+	DeferredEntity deferred = commands.CreateEntity();
+	commands.AddComponent(deferred, Position{});
+	commands.AddComponent(archetypeEntity, Health{});
+
+	bool threw = false;
+	try
+	{
+		commands.Playback(registry);
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+	size_t aliveAfterThrow = registry.GetAliveCount();
+
+	//Nothing left to replay, the deferred entity is not created a second time
+	commands.Playback(registry);
+	CHECK(registry.GetAliveCount() == aliveAfterThrow);
+	CHECK(registry.GetAllComponents<Position>().size() == 1);
+}
@@ -0,0 +1,143 @@
+#include "Test.h"
+
+#include "World/ECS/Registry.h"
+
+namespace {
+	struct Position
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+	struct Velocity
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+	struct Mass
+	{
+		float value = 1.0f;
+	};
+}
+
+TEST(UnknownHandleIsNotArchetypeEntity)
+{
+	Registry registry;
+	registry.CreateEntity(StoragePolicy::Archetype, Position{ 1.0f });
+
+	//Index past anything created so far
+	EntityID unknown = MakeEntityID(1000, 0);
+	CHECK(!registry.IsArchetypeEntity(unknown));
+	registry.RemoveComponent<Position>(unknown);
+}
+
+TEST(StaleHandleDoesNotRemoveFromArchetypeEntity)
+{
+	Registry registry;
+	EntityID stale = registry.CreateEntity(StoragePolicy::SparseSet, Position{ 1.0f });
+	registry.RemoveEntity(stale);
+
+	//Recycles the index with a new version
+	EntityID current = registry.CreateEntity(StoragePolicy::Archetype, Position{ 2.0f });
+	CHECK(GetEntityIndex(current) == GetEntityIndex(stale));
+	CHECK(registry.IsArchetypeEntity(current));
+	CHECK(!registry.IsArchetypeEntity(stale));
+
+	//Would throw for a live archetype entity
+	registry.RemoveComponent<Position>(stale);
+	CHECK(registry.GetComponent<Position>(current).x == 2.0f);
+}
+
+//A system touching three components, once through the sparse sets and once streaming archetype chunks
+BENCHMARK(ArchetypeVsSparseSetIteration)
+{
+	constexpr size_t EntityCount = 100000;
+
+	Registry sparseRegistry;
+	Registry archetypeRegistry;
+	for (size_t i = 0; i < EntityCount; ++i)
+	{
+		Position position{ static_cast<float>(i) };
+		Velocity velocity{ 1.0f, 2.0f, 3.0f };
+		sparseRegistry.CreateEntity(StoragePolicy::SparseSet, position, velocity, Mass{});
+		archetypeRegistry.CreateEntity(StoragePolicy::Archetype, position, velocity, Mass{});
+	}
+
+	double sparseMs = Test::TimeMs([&]
+	{
+		sparseRegistry.View<Position, Velocity, Mass>().Each([](EntityID, Position& position, Velocity& velocity, Mass& mass)
+		{
+			position.x += velocity.x * mass.value;
+			position.y += velocity.y * mass.value;
+			position.z += velocity.z * mass.value;
+		});
+	});
+	double archetypeMs = Test::TimeMs([&]
+	{
+		archetypeRegistry.EachChunk<Position, Velocity, Mass>([](uint32_t count, const EntityID*, Position* positions, Velocity* velocities, Mass* masses)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				positions[i].x += velocities[i].x * masses[i].value;
+				positions[i].y += velocities[i].y * masses[i].value;
+				positions[i].z += velocities[i].z * masses[i].value;
+			}
+		});
+	});
+
+	//Both ran the same number of steps over the same starting values
+	double sparseSum = 0.0, archetypeSum = 0.0;
+	sparseRegistry.View<Position>().Each([&](EntityID, Position& position) { sparseSum += position.z; });
+	archetypeRegistry.EachChunk<Position>([&](uint32_t count, const EntityID*, Position* positions)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			archetypeSum += positions[i].z;
+	});
+	CHECK(sparseSum == archetypeSum);
+
+	Test::Report("sparse set View, 100k x 3 components", sparseMs);
+	Test::Report("archetype chunks, 100k x 3 components", archetypeMs);
+}
+
+TEST(CreateEntitiesGivesEveryEntityTheComponents)
+{
+	Registry registry;
+	registry.CreateEntity();
+	std::vector<EntityID> entities = registry.CreateEntities(100, Position{ 1.0f }, Mass{ 2.0f });
+
+	size_t viewed = 0;
+	registry.View<Position, Mass>().Each([&](EntityID, Position& position, Mass& mass)
+	{
+		CHECK(position.x == 1.0f && mass.value == 2.0f);
+		++viewed;
+	});
+	CHECK(entities.size() == 100);
+	CHECK(viewed == 100);
+	CHECK(registry.GetAliveCount() == 101);
+}
+
+//A 50k particle burst, bulk creation against one CreateEntity and two SetComponent calls per entity
+BENCHMARK(CreateEntitiesVsPerEntityInsertion)
+{
+	constexpr size_t EntityCount = 50000;
+
+	size_t bulkCount = 0, singleCount = 0;
+	double bulkMs = Test::TimeMs([&]
+	{
+		Registry registry;
+		registry.CreateEntities(EntityCount, Position{}, Velocity{});
+		bulkCount = registry.GetAliveCount();
+	});
+	double singleMs = Test::TimeMs([&]
+	{
+		Registry registry;
+		for (size_t i = 0; i < EntityCount; ++i)
+		{
+			EntityID entity = registry.CreateEntity();
+			registry.SetComponent(entity, Position{});
+			registry.SetComponent(entity, Velocity{});
+		}
+		singleCount = registry.GetAliveCount();
+	});
+
+	CHECK(bulkCount == EntityCount && singleCount == EntityCount);
+	Test::Report("CreateEntities, 50k", bulkMs);
+	Test::Report("CreateEntity + SetComponent, 50k", singleMs);
+}
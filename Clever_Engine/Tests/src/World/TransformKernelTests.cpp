@@ -0,0 +1,120 @@
+#include "Test.h"
+
+#include <cmath>
+#include <random>
+#include <gtc/matrix_transform.hpp>
+#include <gtx/quaternion.hpp>
+
+#include "World/TransformKernel.h"
+
+namespace {
+	std::vector<Transform> RandomTransforms(size_t count)
+	{
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+		std::vector<Transform> transforms(count);
+		for (Transform& transform : transforms)
+		{
+			transform.position = glm::vec3(position(gen), position(gen), position(gen));
+			transform.rotation = glm::normalize(glm::vec4(unit(gen), unit(gen), unit(gen), unit(gen)));
+			transform.scale = glm::vec3(scale(gen), scale(gen), scale(gen));
+		}
+		return transforms;
+	}
+
+	//Spelled out instead of calling Transform::UpdateModelMatrix so a change there cannot hide a mismatch
+	glm::mat4 GlmModelMatrix(const Transform& transform)
+	{
+		glm::quat rotation(transform.rotation.w, transform.rotation.x, transform.rotation.y, transform.rotation.z);
+		return glm::translate(glm::mat4(1.0f), transform.position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), transform.scale);
+	}
+
+	bool NearlyEqual(const glm::mat4& expected, const glm::mat4& actual)
+	{
+		for (int column = 0; column < 4; ++column)
+			for (int row = 0; row < 4; ++row)
+				if (std::abs(expected[column][row] - actual[column][row]) > 1e-5f * std::max(1.0f, std::abs(expected[column][row])))
+					return false;
+		return true;
+	}
+
+	//Every count up to a few full registers, so each path is checked with every tail length behind a full batch
+	void CheckEveryLane(void (*compose)(const TransformSoA&, glm::mat4*))
+	{
+		std::vector<Transform> transforms = RandomTransforms(19);
+		for (size_t count = 0; count <= transforms.size(); ++count)
+		{
+			TransformSoA batch;
+			for (size_t i = 0; i < count; ++i)
+				batch.PushBack(transforms[i]);
+
+			//One past the batch stays untouched
+			std::vector<glm::mat4> out(count + 1, glm::mat4(-7.0f));
+			compose(batch, out.data());
+			for (size_t i = 0; i < count; ++i)
+				CHECK(NearlyEqual(GlmModelMatrix(transforms[i]), out[i]));
+			CHECK(out[count] == glm::mat4(-7.0f));
+		}
+	}
+}
+
+TEST(ScalarComposeMatchesGlmOnEveryLane)
+{
+	CheckEveryLane([](const TransformSoA& batch, glm::mat4* out) { ComposeModelMatricesScalar(batch, 0, batch.size(), out); });
+}
+
+TEST(DispatchedComposeMatchesGlmOnEveryLane)
+{
+	CheckEveryLane(ComposeModelMatrices);
+}
+
+#ifdef CLEVER_TRANSFORM_X64
+TEST(SSEComposeMatchesGlmOnEveryLane)
+{
+	CheckEveryLane(ComposeModelMatricesSSE);
+}
+
+TEST(AVX2ComposeMatchesGlmOnEveryLane)
+{
+	if (!CpuSupportsAVX2())
+	{
+		std::cout << "  skipped, no AVX2\n";
+		return;
+	}
+	CheckEveryLane(ComposeModelMatricesAVX2);
+}
+#endif
+
+//A million changed transforms, per entity glm against the batched kernel on each path
+BENCHMARK(ComposeOneMillionModelMatrices)
+{
+	constexpr size_t TransformCount = 1000000;
+
+	std::vector<Transform> transforms = RandomTransforms(TransformCount);
+	TransformSoA batch;
+	batch.Reserve(TransformCount);
+	for (const Transform& transform : transforms)
+		batch.PushBack(transform);
+	std::vector<glm::mat4> out(TransformCount);
+
+	double glmMs = Test::TimeMs([&]
+	{
+		for (Transform& transform : transforms)
+			transform.UpdateModelMatrix();
+	});
+	double scalarMs = Test::TimeMs([&] { ComposeModelMatricesScalar(batch, 0, TransformCount, out.data()); });
+	double dispatchMs = Test::TimeMs([&] { ComposeModelMatrices(batch, out.data()); });
+	CHECK(NearlyEqual(transforms.back().modelMatrix, out.back()));
+
+	Test::Report("Transform::UpdateModelMatrix, 1M", glmMs);
+	Test::Report("ComposeModelMatricesScalar, 1M", scalarMs);
+	Test::Report("ComposeModelMatrices, 1M", dispatchMs);
+#ifdef CLEVER_TRANSFORM_X64
+	Test::Report("ComposeModelMatricesSSE, 1M", Test::TimeMs([&] { ComposeModelMatricesSSE(batch, out.data()); }));
+	if (CpuSupportsAVX2())
+		Test::Report("ComposeModelMatricesAVX2, 1M", Test::TimeMs([&] { ComposeModelMatricesAVX2(batch, out.data()); }));
+#endif
+}
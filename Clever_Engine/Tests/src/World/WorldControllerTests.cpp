@@ -0,0 +1,111 @@
+#include "Test.h"
+
+#include "World/WorldController.h"
+
+namespace {
+	//What the Engine loop runs after BeginFrame and the gameplay writes
+	void FinishFrame(WorldController& world, JobSystem& jobSystem)
+	{
+		world.FlushCommands();
+		world.Update(jobSystem);
+	}
+}
+
+TEST(EveryFrameAdvancesTheTickOnce)
+{
+	WorldController world;
+	JobSystem jobSystem(1);
+	ChangeTick startTick = world.GetRegistry().GetTick();
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		world.BeginFrame();
+		FinishFrame(world, jobSystem);
+	}
+	CHECK(world.GetRegistry().GetTick() == startTick + 3);
+}
+
+TEST(VisableFollowsTransformEveryFrame)
+{
+	WorldController world;
+	JobSystem jobSystem(1);
+	Registry& registry = world.GetRegistry();
+	EntityID entity = registry.CreateEntity(StoragePolicy::SparseSet, Transform{}, Visable{});
+
+	//More frames than the change history, each one moving the entity before Update
+	for (int frame = 1; frame <= 12; ++frame)
+	{
+		world.BeginFrame();
+		registry.Patch<Transform>(entity).position.x += 1.0f;
+		FinishFrame(world, jobSystem);
+		CHECK(registry.GetComponent<Visable>(entity).matrix[3].x == static_cast<float>(frame));
+	}
+}
+
+TEST(DetachedChildFallsBackToItsLocalMatrix)
+{
+	WorldController world;
+	JobSystem jobSystem(1);
+	Registry& registry = world.GetRegistry();
+	Transform parentTransform{};
+	parentTransform.position.x = 10.0f;
+	Transform childTransform{};
+	childTransform.position.x = 1.0f;
+	EntityID parent = registry.CreateEntity(StoragePolicy::SparseSet, parentTransform, Visable{});
+	EntityID child = registry.CreateEntity(StoragePolicy::SparseSet, childTransform, Visable{});
+
+	world.BeginFrame();
+	world.SetParent(child, parent);
+	FinishFrame(world, jobSystem);
+	CHECK(registry.GetComponent<Visable>(child).matrix[3].x == 11.0f);
+
+	world.BeginFrame();
+	world.RemoveParent(child);
+	FinishFrame(world, jobSystem);
+	CHECK(registry.GetComponent<Visable>(child).matrix[3].x == 1.0f);
+	CHECK(registry.GetComponent<Visable>(parent).matrix[3].x == 10.0f);
+}
+
+TEST(RemovedChildrenArePrunedFromTheirParent)
+{
+	WorldController world;
+	JobSystem jobSystem(1);
+	Registry& registry = world.GetRegistry();
+	EntityID parent = registry.CreateEntity(StoragePolicy::SparseSet, Transform{}, Visable{});
+	EntityID kept = registry.CreateEntity(StoragePolicy::SparseSet, Transform{}, Visable{});
+	EntityID removed = registry.CreateEntity(StoragePolicy::SparseSet, Transform{}, Visable{});
+
+	world.BeginFrame();
+	world.SetParent(kept, parent);
+	world.SetParent(removed, parent);
+	FinishFrame(world, jobSystem);
+
+	world.BeginFrame();
+	registry.RemoveEntity(removed);
+	FinishFrame(world, jobSystem);
+
+	const std::vector<EntityID>& children = registry.GetComponent<Children>(parent).entities;
+	CHECK(children.size() == 1 && children[0] == kept);
+}
+
+TEST(ChildLosingItsTransformLeavesTheHierarchy)
+{
+	WorldController world;
+	JobSystem jobSystem(1);
+	Registry& registry = world.GetRegistry();
+	Transform parentTransform{};
+	parentTransform.position.x = 10.0f;
+	EntityID parent = registry.CreateEntity(StoragePolicy::SparseSet, parentTransform, Visable{});
+	EntityID child = registry.CreateEntity(StoragePolicy::SparseSet, Transform{}, Visable{});
+
+	world.BeginFrame();
+	world.SetParent(child, parent);
+	FinishFrame(world, jobSystem);
+
+	//The Transform storage is now shorter than the cached order
+	world.BeginFrame();
+	registry.RemoveComponent<Transform>(child);
+	FinishFrame(world, jobSystem);
+
+	CHECK(world.GetRegistry().GetAllComponents<Transform>().size() == 1);
+	CHECK(registry.GetComponent<Visable>(parent).matrix[3].x == 10.0f);
+}
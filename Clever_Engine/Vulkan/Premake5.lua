@@ -1,6 +1,12 @@
 -- ================================
 -- Vulkan Static Library
 -- ================================
+
+-- glslc from the Vulkan SDK, source and output relative to res
+local function CompileShader(source, output)
+    return "\"" .. os.getenv("VULKAN_SDK") .. "/Bin/glslc\" \"%{prj.location}/res/" .. source .. "\" -o \"%{prj.location}/res/" .. output .. "\""
+end
+
 project "Vulkan"
     location "."
     kind "StaticLib"
@@ -30,6 +36,15 @@ project "Vulkan"
         "glfw3"
     }
 
+    -- The engine loads the SPIR-V from res at startup, so it is rebuilt from the GLSL before every build
+    prebuildcommands {
+        CompileShader("shader.vert", "vert.spv"),
+        CompileShader("shader.frag", "frag.spv"),
+        CompileShader("cull.comp", "cull.spv"),
+        CompileShader("surface.vert", "surfaceVert.spv"),
+        CompileShader("surface.frag", "surfaceFrag.spv")
+    }
+
     -- filter "configurations:Debug"
     --     runtime "Debug"
     --     symbols "on"
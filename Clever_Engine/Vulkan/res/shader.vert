@@ -3,7 +3,21 @@ layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 fragColor;
 
+// Written by Window::SyncUniformObjectBuffer, one matrix per instance
+layout(std430, set = 0, binding = 0) readonly buffer ModelMatrices {
+    mat4 models[];
+};
+
+// Written by cull.comp, gl_InstanceIndex starts at the draw's firstInstance
+layout(std430, set = 0, binding = 1) readonly buffer VisibleInstances {
+    uint visibleInstances[];
+};
+
+layout(push_constant) uniform SceneConstants {
+    mat4 viewProjection;
+};
+
 void main() {
-    gl_Position = vec4(inPosition, 1.0);
+    gl_Position = viewProjection * models[visibleInstances[gl_InstanceIndex]] * vec4(inPosition, 1.0);
     fragColor = vec3(inPosition.x * 0.5 + 0.5, inPosition.y * 0.5 + 0.5, 0.0);
 }
\ No newline at end of file
@@ -3,14 +3,14 @@ layout(location = 0) in vec2 fragUV;
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 0) uniform sampler2D sceneImages[16];
-//16 current max number of scenes
+//One layer per scene, the scene covers uvScale of it from the top left
+layout(set = 0, binding = 0) uniform sampler2DArray sceneLayers;
 
 layout(push_constant) uniform PushConstants {
-    int sceneIndex;
+    vec2 uvScale;
+    int sceneLayer;
 } pc;
 
 void main() {
-    //outColor = vec4(float(), 0.5, 0.0, 1.0);
-    outColor = texture(sceneImages[pc.sceneIndex], fragUV);
+    outColor = texture(sceneLayers, vec3(fragUV * pc.uvScale, pc.sceneLayer));
 }
\ No newline at end of file
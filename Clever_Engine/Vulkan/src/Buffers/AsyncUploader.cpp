@@ -0,0 +1,226 @@
+#include "AsyncUploader.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#include "Memory/MemoryAllocator.h"
+
+namespace Vulkan {
+
+	AsyncUploader::AsyncUploader(VkDevice device, VkQueue queue, uint32_t queueFamily, std::shared_ptr<MemoryAllocator> allocator)
+		: device(device), queue(queue), allocator(std::move(allocator))
+	{
+		VkCommandPoolCreateInfo commandPoolInfo{};
+		commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		commandPoolInfo.queueFamilyIndex = queueFamily;
+		if (vkCreateCommandPool(device, &commandPoolInfo, nullptr, &commandPool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create upload Command Pool!");
+
+		VkSemaphoreTypeCreateInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		timelineInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &timelineInfo;
+		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create upload timeline semaphore!");
+
+		thread = std::thread(&AsyncUploader::UploadThread, this);
+	}
+
+	AsyncUploader::~AsyncUploader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeUp.notify_one();
+		thread.join();
+
+		RecycleBatches(true);
+		if (!freeCommandBuffers.empty())
+			vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(freeCommandBuffers.size()), freeCommandBuffers.data());
+		vkDestroyCommandPool(device, commandPool, nullptr);
+		vkDestroySemaphore(device, timeline, nullptr);
+	}
+
+	uint64_t AsyncUploader::Upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		Request request{ dst, dstOffset, std::vector<uint8_t>(static_cast<size_t>(size)) };
+		memcpy(request.data.data(), data, static_cast<size_t>(size));
+
+		uint64_t value;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queued.push_back(std::move(request));
+			value = nextValue;
+		}
+		wakeUp.notify_one();
+		return value;
+	}
+
+	bool AsyncUploader::IsComplete(uint64_t value) const
+	{
+		if (value == 0)
+			return true;
+		uint64_t counter = 0;
+		vkGetSemaphoreCounterValue(device, timeline, &counter);
+		return counter >= value;
+	}
+
+	void AsyncUploader::WaitIdle()
+	{
+		uint64_t target;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			target = queued.empty() ? nextValue - 1 : nextValue;
+			batchSubmitted.wait(lock, [&] { return submittedValue >= target; });
+		}
+		if (target == 0)
+			return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &timeline;
+		waitInfo.pValues = &target;
+		vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+	}
+
+	void AsyncUploader::UploadThread()
+	{
+		std::vector<Request> requests;
+		while (true)
+		{
+			uint64_t value;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeUp.wait(lock, [&] { return stopping || !queued.empty(); });
+				if (queued.empty())
+					break;
+
+				//Everything queued while the last batch was going out becomes one batch
+				requests.swap(queued);
+				value = nextValue++;
+			}
+
+			RecycleBatches(false);
+			SubmitBatch(requests, value);
+			requests.clear();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				submittedValue = value;
+			}
+			batchSubmitted.notify_all();
+		}
+	}
+
+	void AsyncUploader::SubmitBatch(const std::vector<Request>& requests, uint64_t value)
+	{
+		// --- 1. One staging buffer for the whole batch ---
+		constexpr VkDeviceSize alignment = 16;
+		std::vector<VkDeviceSize> offsets(requests.size());
+		VkDeviceSize totalSize = 0;
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			offsets[i] = totalSize;
+			totalSize = (totalSize + requests[i].data.size() + alignment - 1) & ~(alignment - 1);
+		}
+
+		Batch batch{};
+		batch.value = value;
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = std::max<VkDeviceSize>(totalSize, alignment);
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &batch.staging) != VK_SUCCESS)
+			throw std::runtime_error("failed to create upload staging buffer!");
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(device, batch.staging, &memRequirements);
+		batch.allocation = allocator->Allocate(memRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryAllocator::ResourceKind::Buffer);
+		vkBindBufferMemory(device, batch.staging, batch.allocation.memory, batch.allocation.offset);
+
+		for (size_t i = 0; i < requests.size(); ++i)
+			memcpy(static_cast<uint8_t*>(batch.allocation.mapped) + offsets[i], requests[i].data.data(), requests[i].data.size());
+
+		// --- 2. Record the copies ---
+		if (freeCommandBuffers.empty())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = commandPool;
+			allocInfo.commandBufferCount = 1;
+			freeCommandBuffers.emplace_back();
+			vkAllocateCommandBuffers(device, &allocInfo, &freeCommandBuffers.back());
+		}
+		batch.cmd = freeCommandBuffers.back();
+		freeCommandBuffers.pop_back();
+		vkResetCommandBuffer(batch.cmd, 0);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(batch.cmd, &beginInfo);
+
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			VkBufferCopy region{ offsets[i], requests[i].dstOffset, static_cast<VkDeviceSize>(requests[i].data.size()) };
+			vkCmdCopyBuffer(batch.cmd, batch.staging, requests[i].dst, 1, &region);
+		}
+		vkEndCommandBuffer(batch.cmd);
+
+		// --- 3. Submit, the signal makes the copies available to whoever waits on value ---
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.cmd;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &timeline;
+		if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit upload batch!");
+
+		inFlight.push_back(batch);
+	}
+
+	void AsyncUploader::RecycleBatches(bool wait)
+	{
+		if (inFlight.empty())
+			return;
+
+		if (wait)
+		{
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &timeline;
+			waitInfo.pValues = &inFlight.back().value;
+			vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+		}
+
+		uint64_t counter = 0;
+		vkGetSemaphoreCounterValue(device, timeline, &counter);
+		while (!inFlight.empty() && inFlight.front().value <= counter)
+		{
+			Batch& batch = inFlight.front();
+			vkDestroyBuffer(device, batch.staging, nullptr);
+			allocator->Free(batch.allocation);
+			freeCommandBuffers.push_back(batch.cmd);
+			inFlight.pop_front();
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+
+#include "Context/ContextVulkanData.h"
+
+namespace Vulkan {
+
+	/*
+	Uploads buffer data from a background thread on VulkanCore's transferQueue.
+	Everything queued since the last batch goes out as one submit, which signals a timeline semaphore with the batch's value.
+	Upload returns that value, so the render loop only makes the GPU wait on it in the frame that first uses the data.
+	Destination buffers need TRANSFER_DST usage, CreateBuffer makes those shared with the transfer family.
+	*/
+	class AsyncUploader
+	{
+	public:
+		AsyncUploader(VkDevice device, VkQueue queue, uint32_t queueFamily, std::shared_ptr<MemoryAllocator> allocator);
+		~AsyncUploader();
+
+		//Copies data, the caller can free it straight away. Returns the timeline value the upload is done at
+		uint64_t Upload(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		//0 always counts as complete
+		bool IsComplete(uint64_t value) const;
+		//Blocks until everything queued so far has landed, for destroying buffers uploads might still write to
+		void WaitIdle();
+
+		VkSemaphore GetTimelineSemaphore() const { return timeline; }
+
+		AsyncUploader(const AsyncUploader&) = delete;
+		AsyncUploader& operator=(const AsyncUploader&) = delete;
+	private:
+		struct Request
+		{
+			VkBuffer dst;
+			VkDeviceSize dstOffset;
+			std::vector<uint8_t> data;
+		};
+
+		struct Batch
+		{
+			uint64_t value;
+			VkCommandBuffer cmd;
+			VkBuffer staging;
+			MemoryAllocation allocation;
+		};
+
+		void UploadThread();
+		void SubmitBatch(const std::vector<Request>& requests, uint64_t value);
+		//Frees the staging memory of batches the GPU is done with, or of all of them with wait set
+		void RecycleBatches(bool wait);
+	private:
+		VkDevice device;
+		VkQueue queue;
+		std::shared_ptr<MemoryAllocator> allocator;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkSemaphore timeline = VK_NULL_HANDLE;
+
+		//Only touched by the upload thread
+		std::deque<Batch> inFlight;
+		std::vector<VkCommandBuffer> freeCommandBuffers;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::condition_variable batchSubmitted;
+		std::vector<Request> queued;
+		uint64_t nextValue = 1;      // Value the batch being gathered will signal
+		uint64_t submittedValue = 0; // Value of the last batch handed to the queue
+		bool stopping = false;
+
+		std::thread thread;
+	};
+}
@@ -3,14 +3,11 @@
 #include <stdexcept> 
 
 #include "Context/ContextVulkanData.h"
+#include "Memory/MemoryAllocator.h"
 
 namespace Vulkan {
-	struct VulkanBuffer {
-		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
-		VkDeviceSize size = 0;
-		VkDeviceSize capacity = 0;
-	};
+	inline void CreateBuffer(std::shared_ptr<VulkanCore> VC, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& allocation);
+	inline void CopyBuffer(std::shared_ptr<VulkanCore> VC, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
 	inline uint32_t FindMemoryType(
 		VkPhysicalDevice physicalDevice,
@@ -74,10 +71,20 @@ namespace Vulkan {
 			usage,
 			memoryFlags,
 			outBuffer.buffer,
-			outBuffer.memory
+			outBuffer.allocation
 		);
+		outBuffer.mapped = outBuffer.allocation.mapped;
 	}
 
+	static void DestroyBuffer(std::shared_ptr<VulkanCore> vc, VulkanBuffer& buffer)
+	{
+		if (buffer.buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(vc->vkDevice, buffer.buffer, nullptr);
+		vc->memoryAllocator->Free(buffer.allocation);
+		buffer = VulkanBuffer{};
+	}
+
+	// Blocks until the copy is done, per frame uploads go through a StagingRing instead
 	static void UploadViaStaging(
 		std::shared_ptr<VulkanCore> vc,
 		VulkanBuffer& dst,
@@ -87,38 +94,34 @@ namespace Vulkan {
 	{
 		assert(dataSize <= dst.capacity && "GPU buffer overflow");
 
-		VkBuffer staging;
-		VkDeviceMemory stagingMem;
+		VulkanBuffer staging{};
 
-		CreateBuffer(
+		CreateBufferInternal(
 			vc,
 			dataSize,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			staging,
-			stagingMem
+			staging
 		);
 
-		void* mapped;
-		vkMapMemory(vc->vkDevice, stagingMem, 0, dataSize, 0, &mapped);
-		memcpy(mapped, data, static_cast<size_t>(dataSize));
-		vkUnmapMemory(vc->vkDevice, stagingMem);
+		memcpy(staging.mapped, data, static_cast<size_t>(dataSize));
 
-		CopyBuffer(vc, staging, dst.buffer, dataSize);
+		CopyBuffer(vc, staging.buffer, dst.buffer, dataSize);
 
-		vkDestroyBuffer(vc->vkDevice, staging, nullptr);
-		vkFreeMemory(vc->vkDevice, stagingMem, nullptr);
+		DestroyBuffer(vc, staging);
 
 		dst.size = dataSize;
 	}
 
+	//With a deletionQueue the old buffer waits there for the frames in flight instead of being destroyed right after the copy
 	void EnsureCapacity(
 		std::shared_ptr<VulkanCore> vc,
 		VulkanBuffer& buffer,
 		VkDeviceSize requiredSize,
 		VkBufferUsageFlags usage,
-		VkMemoryPropertyFlags memoryFlags
+		VkMemoryPropertyFlags memoryFlags,
+		DeletionQueue* deletionQueue = nullptr
 	)
 	{
 		if (requiredSize <= buffer.capacity)
@@ -130,7 +133,7 @@ namespace Vulkan {
 		VulkanBuffer newBuffer{};
 		newBuffer.capacity = newCapacity;
 
-		CreateBufferInternal(vc, newCapacity, usage, memoryFlags, newBuffer);
+		CreateBufferInternal(vc, newCapacity, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, memoryFlags, newBuffer);
 
 		// Copy old data
 		if (buffer.size > 0)
@@ -139,8 +142,11 @@ namespace Vulkan {
 		}
 
 		// Destroy old buffer
-		vkDestroyBuffer(vc->vkDevice, buffer.buffer, nullptr);
-		vkFreeMemory(vc->vkDevice, buffer.memory, nullptr);
+		newBuffer.size = buffer.size;
+		if (deletionQueue)
+			deletionQueue->Push(buffer);
+		else
+			DestroyBuffer(vc, buffer);
 
 		buffer = newBuffer;
 	}
@@ -164,7 +170,7 @@ namespace Vulkan {
 		return buffer;
 	}
 
-	inline void CreateBuffer(std::shared_ptr<VulkanCore> VC, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	inline void CreateBuffer(std::shared_ptr<VulkanCore> VC, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& allocation)
 	{
 		VkBufferCreateInfo bufferInfo{};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -172,6 +178,16 @@ namespace Vulkan {
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		//The AsyncUploader writes from its own queue family, sharing saves ownership transfers on every upload
+		const PhysicalDeviceData& queues = VC->d_PhysicalDeviceData;
+		uint32_t queueFamilies[2] = { queues.graphicsIndex.value(), queues.transferIndex.value_or(queues.graphicsIndex.value()) };
+		if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && VC->transferQueue != VK_NULL_HANDLE && queueFamilies[0] != queueFamilies[1])
+		{
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = 2;
+			bufferInfo.pQueueFamilyIndices = queueFamilies;
+		}
+
 		if (vkCreateBuffer(VC->vkDevice, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create vertex buffer!");
 		}
@@ -179,17 +195,8 @@ namespace Vulkan {
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements(VC->vkDevice, buffer, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(VC->vkPhysicalDevice, memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(VC->vkDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate vertex buffer memory!");
-		}
-
-		vkBindBufferMemory(VC->vkDevice, buffer, bufferMemory, 0);
+		allocation = VC->memoryAllocator->Allocate(memRequirements, properties, MemoryAllocator::ResourceKind::Buffer);
+		vkBindBufferMemory(VC->vkDevice, buffer, allocation.memory, allocation.offset);
 	}
 
 	inline void CopyBuffer(std::shared_ptr<VulkanCore> VC, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -233,10 +240,7 @@ namespace Vulkan {
 	{
 		assert(dataSize <= buffer.capacity);
 
-		void* mapped;
-		vkMapMemory(vc->vkDevice, buffer.memory, 0, dataSize, 0, &mapped);
-		memcpy(mapped, data, static_cast<size_t>(dataSize));
-		vkUnmapMemory(vc->vkDevice, buffer.memory);
+		memcpy(buffer.mapped, data, static_cast<size_t>(dataSize));
 
 		buffer.size = dataSize;
 	}
@@ -254,7 +258,8 @@ namespace Vulkan {
 			vc,
 			capacityBytes,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // Source when growing
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			buffer
 		);
@@ -293,7 +298,8 @@ namespace Vulkan {
 			vc,
 			capacityBytes,
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			buffer
 		);
@@ -332,7 +338,8 @@ namespace Vulkan {
 			vc,
 			capacityBytes,
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			buffer
 		);
@@ -371,7 +378,8 @@ namespace Vulkan {
 			vc,
 			capacityBytes,
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			buffer
 		);
@@ -379,6 +387,29 @@ namespace Vulkan {
 		return buffer;
 	}
 
+	// ---------- PERSISTENTLY MAPPED STORAGE BUFFER ----------
+	// Host visible and coherent, written through buffer.mapped until DestroyBuffer
+	static VulkanBuffer CreateMappedStorageBuffer(
+		std::shared_ptr<VulkanCore> vc,
+		VkDeviceSize capacityBytes,
+		VkBufferUsageFlags extraUsage = 0
+	)
+	{
+		VulkanBuffer buffer{};
+		buffer.capacity = capacityBytes;
+
+		CreateBufferInternal(
+			vc,
+			capacityBytes,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | extraUsage,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffer
+		);
+
+		return buffer;
+	}
+
 	static void UpdateStorage(
 		std::shared_ptr<VulkanCore> vc,
 		VulkanBuffer& buffer,
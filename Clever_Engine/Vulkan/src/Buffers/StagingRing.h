@@ -0,0 +1,274 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include "Context/ContextVulkanData.h"
+#include "Buffers/CreateBuffer.h"
+
+namespace Vulkan {
+
+	/*
+	Persistently mapped staging memory, one buffer per frame in flight.
+	Stage copies data in right away and remembers where it goes, RecordCopies then puts all of a frame's copies
+	into that frame's command buffer. The frame fence covers them, so nothing waits on the queue to upload.
+	*/
+	class StagingRing
+	{
+	public:
+		void Create(std::shared_ptr<VulkanCore> vc, uint32_t frameCount, VkDeviceSize initialCapacity = 1024 * 1024)
+		{
+			frames.resize(frameCount);
+			for (FrameStaging& frame : frames)
+				frame.buffer = CreateStagingBuffer(vc, initialCapacity);
+		}
+
+		void Destroy(std::shared_ptr<VulkanCore> vc)
+		{
+			for (FrameStaging& frame : frames)
+			{
+				DestroyBuffer(vc, frame.buffer);
+				for (VulkanBuffer& retired : frame.retired)
+					DestroyBuffer(vc, retired);
+			}
+			frames.clear();
+		}
+
+		//Call once the frame's fence has signalled, its staging space is free again unless copies are still waiting to be recorded
+		void BeginFrame(std::shared_ptr<VulkanCore> vc, uint32_t frame)
+		{
+			FrameStaging& staging = frames[frame];
+			if (!staging.copies.empty() || !staging.growCopies.empty())
+				return;
+
+			staging.head = 0;
+			for (VulkanBuffer& retired : staging.retired)
+				DestroyBuffer(vc, retired);
+			staging.retired.clear();
+		}
+
+		//dst has to have TRANSFER_DST usage, the copy lands when the frame's command buffer runs
+		void Stage(std::shared_ptr<VulkanCore> vc, uint32_t frame, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+		{
+			if (size == 0)
+				return;
+
+			FrameStaging& staging = frames[frame];
+			VkDeviceSize offset = (staging.head + StagingAlignment - 1) & ~(StagingAlignment - 1);
+			if (offset + size > staging.buffer.capacity)
+			{
+				//Copies already staged still read from the old buffer, it goes once this frame comes around again
+				staging.retired.push_back(staging.buffer);
+				staging.buffer = CreateStagingBuffer(vc, std::max(size, staging.buffer.capacity * 2));
+				offset = 0;
+			}
+
+			memcpy(static_cast<uint8_t*>(staging.buffer.mapped) + offset, data, static_cast<size_t>(size));
+			staging.head = offset + size;
+
+			//Back to back copies into the same buffer become one region
+			if (!staging.copies.empty())
+			{
+				PendingCopy& last = staging.copies.back();
+				if (last.src == staging.buffer.buffer && last.dst == dst &&
+					last.region.srcOffset + last.region.size == offset && last.region.dstOffset + last.region.size == dstOffset)
+				{
+					last.region.size += size;
+					return;
+				}
+			}
+			staging.copies.push_back({ staging.buffer.buffer, dst, VkBufferCopy{ offset, dstOffset, size } });
+		}
+
+		//Queues a GPU side copy of the first size bytes of src into dst, recorded before any staged copy of the frame
+		void QueueGrowCopy(uint32_t frame, VkBuffer src, VkBuffer dst, VkDeviceSize size)
+		{
+			//Grown twice before being recorded, src never got the old contents so they go straight to dst
+			for (PendingCopy& copy : frames[frame].growCopies)
+			{
+				if (copy.dst == src)
+				{
+					copy.dst = dst;
+					return;
+				}
+			}
+			if (size > 0)
+				frames[frame].growCopies.push_back({ src, dst, VkBufferCopy{ 0, 0, size } });
+		}
+
+		//Points copies that have not been recorded yet at a buffer that replaced their destination
+		void RetargetCopies(VkBuffer oldDst, VkBuffer newDst)
+		{
+			for (FrameStaging& staging : frames)
+			{
+				for (PendingCopy& copy : staging.copies)
+				{
+					if (copy.dst == oldDst)
+						copy.dst = newDst;
+				}
+			}
+		}
+
+		//Drops copies into dst that have not been recorded yet, for buffers that are about to be destroyed
+		void DropCopies(VkBuffer dst)
+		{
+			auto targetsDst = [dst](const PendingCopy& copy) { return copy.dst == dst; };
+			for (FrameStaging& staging : frames)
+			{
+				staging.copies.erase(std::remove_if(staging.copies.begin(), staging.copies.end(), targetsDst), staging.copies.end());
+				staging.growCopies.erase(std::remove_if(staging.growCopies.begin(), staging.growCopies.end(), targetsDst), staging.growCopies.end());
+			}
+		}
+
+		bool HasPendingCopies(uint32_t frame) const
+		{
+			return !frames[frame].copies.empty() || !frames[frame].growCopies.empty();
+		}
+
+		//Records the frame's copies with barriers on both sides, everything after cmd in queue order sees the new data
+		void RecordCopies(VkCommandBuffer cmd, uint32_t frame)
+		{
+			FrameStaging& staging = frames[frame];
+			if (!HasPendingCopies(frame))
+				return;
+
+			//Earlier frames may still be reading the destinations, and earlier copies or compute writes into them
+			//have to be visible before these copies read the old contents or write over them
+			VkMemoryBarrier leadingBarrier{};
+			leadingBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			leadingBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			leadingBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				cmd,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				1, &leadingBarrier,
+				0, nullptr,
+				0, nullptr
+			);
+
+			//Old contents first, staged copies may overwrite parts of them
+			if (!staging.growCopies.empty())
+			{
+				for (const PendingCopy& copy : staging.growCopies)
+					vkCmdCopyBuffer(cmd, copy.src, copy.dst, 1, &copy.region);
+
+				VkMemoryBarrier growBarrier{};
+				growBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				growBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				growBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				vkCmdPipelineBarrier(
+					cmd,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT,
+					0,
+					1, &growBarrier,
+					0, nullptr,
+					0, nullptr
+				);
+			}
+
+			for (const PendingCopy& copy : staging.copies)
+				vkCmdCopyBuffer(cmd, copy.src, copy.dst, 1, &copy.region);
+
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask =
+				VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+				VK_ACCESS_INDEX_READ_BIT |
+				VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+				VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				cmd,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+				VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0,
+				1, &barrier,
+				0, nullptr,
+				0, nullptr
+			);
+
+			staging.copies.clear();
+			staging.growCopies.clear();
+		}
+
+	private:
+		struct PendingCopy
+		{
+			VkBuffer src;
+			VkBuffer dst;
+			VkBufferCopy region;
+		};
+
+		struct FrameStaging
+		{
+			VulkanBuffer buffer{};
+			VkDeviceSize head = 0;
+			std::vector<PendingCopy> copies{};
+			//Old contents of buffers replaced while growing
+			std::vector<PendingCopy> growCopies{};
+			//Outgrown buffers that copies of this frame still read from
+			std::vector<VulkanBuffer> retired{};
+		};
+
+		static VulkanBuffer CreateStagingBuffer(std::shared_ptr<VulkanCore> vc, VkDeviceSize capacity)
+		{
+			VulkanBuffer buffer{};
+			buffer.capacity = capacity;
+			CreateBufferInternal(
+				vc,
+				capacity,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				buffer
+			);
+			return buffer;
+		}
+
+		static constexpr VkDeviceSize StagingAlignment = 16;
+		std::vector<FrameStaging> frames{};
+	};
+
+	/*
+	EnsureCapacity without the waits, for buffers frames may still be drawing from.
+	The old contents are copied on the GPU at the start of frame, copies staged for the old buffer go to the new one.
+	The old buffer goes to deletionQueue, frames in flight may still be drawing from it.
+	*/
+	inline bool EnsureCapacityDeferred(
+		std::shared_ptr<VulkanCore> vc,
+		StagingRing& ring,
+		uint32_t frame,
+		VulkanBuffer& buffer,
+		VkDeviceSize requiredSize,
+		VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags memoryFlags,
+		float growthFactor,
+		DeletionQueue& deletionQueue
+	)
+	{
+		if (requiredSize <= buffer.capacity)
+			return false;
+
+		VkDeviceSize grown = static_cast<VkDeviceSize>(static_cast<double>(buffer.capacity) * growthFactor);
+		VulkanBuffer newBuffer{};
+		newBuffer.capacity = std::max(requiredSize, grown);
+		newBuffer.size = buffer.size;
+		CreateBufferInternal(vc, newBuffer.capacity, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, newBuffer);
+
+		if (buffer.buffer != VK_NULL_HANDLE)
+		{
+			ring.QueueGrowCopy(frame, buffer.buffer, newBuffer.buffer, buffer.size);
+			ring.RetargetCopies(buffer.buffer, newBuffer.buffer);
+			deletionQueue.Push(buffer);
+		}
+
+		buffer = newBuffer;
+		return true;
+	}
+}
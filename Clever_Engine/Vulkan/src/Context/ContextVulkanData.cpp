@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <iostream>
+#include <algorithm>
 
 #include "Surface/CreateVulkanSurface.h"
 #include "Surface/CreateSwapChain.h"
@@ -16,7 +17,155 @@
 #include "Scene/CreateDescriptors.h"
 #include "Scene/CreatePipelines.h"
 
+#include "Buffers/CreateBuffer.h"
+#include "Buffers/AsyncUploader.h"
+#include "Memory/MemoryAllocator.h"
+
 namespace Vulkan {
+	void VulkanImage::Destory(VulkanCore& vulkanCore)
+	{
+		if (view != VK_NULL_HANDLE) {
+			vkDestroyImageView(vulkanCore.vkDevice, view, nullptr);
+			view = VK_NULL_HANDLE;
+		}
+		if (image != VK_NULL_HANDLE) {
+			vkDestroyImage(vulkanCore.vkDevice, image, nullptr);
+			image = VK_NULL_HANDLE;
+		}
+		vulkanCore.memoryAllocator->Free(allocation);
+	}
+
+	void DeletionQueue::Push(const VulkanBuffer& buffer, uint64_t uploadValue)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.uploadValue = uploadValue;
+		entry.buffer = buffer.buffer;
+		entry.allocation = buffer.allocation;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(const VulkanImage& image)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.view = image.view;
+		entry.image = image.image;
+		entry.allocation = image.allocation;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkImageView view)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.view = view;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkFramebuffer framebuffer)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.framebuffer = framebuffer;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkSwapchainKHR swapchain)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.swapchain = swapchain;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkPipeline pipeline)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.pipeline = pipeline;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkPipelineLayout pipelineLayout)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.pipelineLayout = pipelineLayout;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkRenderPass renderPass)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.renderPass = renderPass;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkCommandPool commandPool)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.commandPool = commandPool;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Push(VkDeviceMemory memory)
+	{
+		Entry entry{};
+		entry.frameNumber = frameNumber;
+		entry.memory = memory;
+		entries.push_back(entry);
+	}
+
+	void DeletionQueue::Collect(VulkanCore& vulkanCore, uint32_t framesInFlight)
+	{
+		//The fence just waited on is the one of frame frameNumber - framesInFlight, it and every frame before it are done
+		auto done = [&](Entry& entry) {
+			if (entry.frameNumber + framesInFlight > frameNumber)
+				return false;
+			if (vulkanCore.uploader && !vulkanCore.uploader->IsComplete(entry.uploadValue))
+				return false;
+			Destroy(vulkanCore, entry);
+			return true;
+		};
+		entries.erase(std::remove_if(entries.begin(), entries.end(), done), entries.end());
+	}
+
+	void DeletionQueue::Flush(VulkanCore& vulkanCore)
+	{
+		for (Entry& entry : entries)
+			Destroy(vulkanCore, entry);
+		entries.clear();
+	}
+
+	void DeletionQueue::Destroy(VulkanCore& vulkanCore, Entry& entry)
+	{
+		VkDevice device = vulkanCore.vkDevice;
+		if (entry.framebuffer != VK_NULL_HANDLE)
+			vkDestroyFramebuffer(device, entry.framebuffer, nullptr);
+		if (entry.view != VK_NULL_HANDLE)
+			vkDestroyImageView(device, entry.view, nullptr);
+		if (entry.image != VK_NULL_HANDLE)
+			vkDestroyImage(device, entry.image, nullptr);
+		if (entry.buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(device, entry.buffer, nullptr);
+		vulkanCore.memoryAllocator->Free(entry.allocation);
+		if (entry.memory != VK_NULL_HANDLE)
+			vkFreeMemory(device, entry.memory, nullptr);
+		if (entry.swapchain != VK_NULL_HANDLE)
+			vkDestroySwapchainKHR(device, entry.swapchain, nullptr);
+		if (entry.pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(device, entry.pipeline, nullptr);
+		if (entry.pipelineLayout != VK_NULL_HANDLE)
+			vkDestroyPipelineLayout(device, entry.pipelineLayout, nullptr);
+		if (entry.renderPass != VK_NULL_HANDLE)
+			vkDestroyRenderPass(device, entry.renderPass, nullptr);
+		if (entry.commandPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(device, entry.commandPool, nullptr);
+	}
+
 	void VulkanSurface::CreateSurfaceResources(std::shared_ptr<VulkanCore> vulkanCore, GLFWwindow* p_GLFWWindow)
 	{
 		this->p_GLFWWindow = p_GLFWWindow;
@@ -62,64 +211,29 @@ namespace Vulkan {
 			surfaceRenderFinishedSemaphores,
 			surfaceFences
 		);
+		inFlightFences = surfaceFences;
 
 		offscreenSampler = CreateOffscreenSampler(vulkanCore);
-		CreateEmptyStartingDescriptors(vulkanCore, 16);
-	}
-
-	int VulkanSurface::AddNewScene(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height)
-	{
-		VulkanCore& VC = *vulkanCore;
 
-		// --- 1. Create offscreen images for each frame in flight ---
-		std::vector<VulkanImage> newSceneImages = initImageByType(
-			VC,
-			ImageType::Color,
-			width,
-			height,
-			MAX_FRAMES_IN_FLIGHT,
-			VK_SAMPLE_COUNT_1_BIT,
-			VK_FORMAT_UNDEFINED
-		);
-
-		for (auto& img : newSceneImages) {
-			TransitionImageLayout(
-				vulkanCore,
-				img.image,
-				img.format,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				VK_IMAGE_ASPECT_COLOR_BIT
-			);
-		}
-
-		std::shared_ptr<std::vector<VulkanImage>> newSceneImagesPtr = std::make_shared<std::vector<VulkanImage>>(std::move(newSceneImages));
-
-		offscreenImages.push_back(newSceneImagesPtr);
-		int sceneIndex = static_cast<int>(offscreenImages.size()) - 1;
-
-		DescriptorBindingInfo& binding = descriptorSetInfo.bindings[0];
-
-		// --- 3. Append new scene images to the existing binding ---
-		for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
-		{
-			VkDescriptorImageInfo info{};
-			info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			info.imageView = offscreenImages[sceneIndex]->at(frame).view;
-			info.sampler = offscreenSampler;
-
-			binding.images[(sceneIndex * MAX_FRAMES_IN_FLIGHT) + frame] = info;
-		}
-
-		// Update descriptor count to match total number of images per frame
-		binding.count = static_cast<uint32_t>(binding.images.size());
-
-		// --- 4. Set maxSets ---
+		// --- Scene layers, one combined image sampler per frame that never changes size ---
+		descriptorSetInfo.bindings.clear();
 		descriptorSetInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+		DescriptorBindingInfo layerBinding{};
+		layerBinding.binding = 0;
+		layerBinding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		layerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		layerBinding.images.resize(MAX_FRAMES_IN_FLIGHT, VkDescriptorImageInfo{ offscreenSampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		descriptorSetInfo.bindings.push_back(layerBinding);
+
+		CreateSceneLayers(vulkanCore, InitialSceneLayerCount, windowSize.x, windowSize.y);
+		freeSceneLayers.clear();
+		for (uint32_t layer = sceneLayerCount; layer > 0; --layer)
+			freeSceneLayers.push_back(layer - 1);
 
 		SurfaceDescriptorResult = CreateDescriptors(vulkanCore, descriptorSetInfo);
+		staleSurfaceDescriptors.assign(MAX_FRAMES_IN_FLIGHT, false);
 
-		// --- 5. Recreate pipeline layout & pipeline (push constants unchanged) ---
+		// --- Composite pipeline, scenes only change push constants so it is built once ---
 		PipelineLayoutInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.setLayouts.push_back(SurfaceDescriptorResult.layout);
 
@@ -138,7 +252,117 @@ namespace Vulkan {
 		pipelineInfo.renderPass = surfaceRenderPass;
 		surfacePipeline = CreateGraphicsPipeline(vulkanCore, pipelineInfo);
 
-		return sceneIndex;
+		CreateInstanceResources(vulkanCore, 1024);
+	}
+
+	uint32_t VulkanSurface::AcquireSceneLayer(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height, bool& imagesReplaced)
+	{
+		imagesReplaced = false;
+		if (freeSceneLayers.empty())
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(vulkanCore->vkPhysicalDevice, &properties);
+			if (sceneLayerCount >= properties.limits.maxImageArrayLayers)
+				throw std::runtime_error("Out of scene layers!");
+
+			uint32_t layerCount = std::min(std::max(sceneLayerCount * 2, 1u), properties.limits.maxImageArrayLayers);
+			for (uint32_t layer = layerCount; layer > sceneLayerCount; --layer)
+				freeSceneLayers.push_back(layer - 1);
+			CreateSceneLayers(vulkanCore, layerCount, std::max(sceneLayerExtent.x, width), std::max(sceneLayerExtent.y, height));
+			imagesReplaced = true;
+		}
+		else
+		{
+			imagesReplaced = FitSceneLayers(vulkanCore, width, height);
+		}
+
+		uint32_t layer = freeSceneLayers.back();
+		freeSceneLayers.pop_back();
+		return layer;
+	}
+
+	void VulkanSurface::ReleaseSceneLayer(uint32_t layer)
+	{
+		freeSceneLayers.push_back(layer);
+	}
+
+	bool VulkanSurface::FitSceneLayers(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height)
+	{
+		if (width <= sceneLayerExtent.x && height <= sceneLayerExtent.y)
+			return false;
+		CreateSceneLayers(vulkanCore, sceneLayerCount, std::max(sceneLayerExtent.x, width), std::max(sceneLayerExtent.y, height));
+		return true;
+	}
+
+	void VulkanSurface::CreateSceneLayers(std::shared_ptr<VulkanCore> vulkanCore, uint32_t layerCount, uint32_t width, uint32_t height)
+	{
+		// Frames in flight may still sample the old images
+		for (VulkanImage& image : sceneLayerImages)
+			deletionQueue.Push(image);
+		sceneLayerImages.assign(MAX_FRAMES_IN_FLIGHT, VulkanImage{});
+		sceneLayerCount = layerCount;
+		sceneLayerExtent = { std::max(width, 1u), std::max(height, 1u) };
+
+		DescriptorBindingInfo& binding = descriptorSetInfo.bindings[0];
+		for (int frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+		{
+			VulkanImage& image = sceneLayerImages[frame];
+			createImage(
+				*vulkanCore,
+				sceneLayerExtent.x,
+				sceneLayerExtent.y,
+				VK_FORMAT_B8G8R8A8_UNORM,
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_SAMPLE_COUNT_1_BIT,
+				sceneLayerCount,
+				0,
+				image
+			);
+			image.view = createImageView(*vulkanCore, image.image, VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_2D_ARRAY, sceneLayerCount);
+			image.format = VK_FORMAT_B8G8R8A8_UNORM;
+			image.extent = { sceneLayerExtent.x, sceneLayerExtent.y, 1 };
+
+			binding.images[frame].imageView = image.view;
+		}
+
+		// The one descriptor of each frame's set is rewritten once the frame comes around, and its image transitioned in
+		// the frame's own command buffer instead of a blocking single time submit
+		staleSurfaceDescriptors.assign(MAX_FRAMES_IN_FLIGHT, true);
+		pendingSceneLayerTransitions.assign(MAX_FRAMES_IN_FLIGHT, true);
+	}
+
+	void VulkanSurface::RecordSceneLayerTransition(VkCommandBuffer cmd, uint32_t frame)
+	{
+		if (!pendingSceneLayerTransitions[frame])
+			return;
+
+		// Free layers are never rendered to but still sit in the sampled view, so every layer starts out readable
+		VulkanImage& image = sceneLayerImages[frame];
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, sceneLayerCount };
+
+		// The scene passes' external dependency waits on all earlier commands, so their own transition of a layer comes after this one
+		vkCmdPipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier
+		);
+		image.currentLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		pendingSceneLayerTransitions[frame] = false;
 	}
 
 
@@ -156,32 +380,26 @@ namespace Vulkan {
 		}
 		windowSize = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
 
-		vkDeviceWaitIdle(vulkanCore.vkDevice);
-		vkWaitForFences(vulkanCore.vkDevice, MAX_FRAMES_IN_FLIGHT, surfaceFences.data(), VK_TRUE, UINT64_MAX);
-
-		// Destroy framebuffers
+		// Frames in flight may still be using the old swapchain, it and everything built on it go to the deletion queue instead of waiting
 		for (auto framebuffer : surfaceFrameBuffers)
 		{
 			if (framebuffer != VK_NULL_HANDLE)
-				vkDestroyFramebuffer(vulkanCore.vkDevice, framebuffer, nullptr);
+				deletionQueue.Push(framebuffer);
 		}
 		surfaceFrameBuffers.clear();
 
-		// Destroy depth images
-		for (auto& image : surfaceDepthImages)
+		for (auto& image : surfaceColorImages)
 		{
-			if (image.view != VK_NULL_HANDLE) vkDestroyImageView(vulkanCore.vkDevice, image.view, nullptr);
-			if (image.image != VK_NULL_HANDLE) vkDestroyImage(vulkanCore.vkDevice, image.image, nullptr);
-			if (image.memory != VK_NULL_HANDLE) vkFreeMemory(vulkanCore.vkDevice, image.memory, nullptr);
+			if (image.view != VK_NULL_HANDLE)
+				deletionQueue.Push(image.view); // The images belong to the swapchain
 		}
-		surfaceDepthImages.clear();
+		surfaceColorImages.clear();
 
-		// Destroy swapchain
-		if (surfaceSwapChain != VK_NULL_HANDLE)
+		for (auto& image : surfaceDepthImages)
 		{
-			vkDestroySwapchainKHR(vulkanCore.vkDevice, surfaceSwapChain, nullptr);
-			surfaceSwapChain = VK_NULL_HANDLE;
+			deletionQueue.Push(image);
 		}
+		surfaceDepthImages.clear();
 
 		SwapChainCreateInfo swapChainCreateInfo{};
 		swapChainCreateInfo.p_GLFWWindow = p_GLFWWindow;
@@ -189,7 +407,10 @@ namespace Vulkan {
 		swapChainCreateInfo.windowSize = windowSize;
 		swapChainCreateInfo.swapChainImageFormat = surfaceswapChainImageFormat;
 		swapChainCreateInfo.flags = flags;
+		swapChainCreateInfo.oldSwapchain = surfaceSwapChain;
 		CreateSwapchain(core, swapChainCreateInfo, surfaceSwapChain);
+		if (swapChainCreateInfo.oldSwapchain != VK_NULL_HANDLE)
+			deletionQueue.Push(swapChainCreateInfo.oldSwapchain);
 		CreateSwapchainImages(core, this, SwapchainAttachmentType::ColorOnly);
 		CreateFrameBuffers(
 			core,
@@ -204,6 +425,7 @@ namespace Vulkan {
 	void VulkanSurface::Destroy(std::shared_ptr<VulkanCore> vulkanCore)
 	{
 		vkDeviceWaitIdle(vulkanCore->vkDevice);
+		deletionQueue.Flush(*vulkanCore);
 
 		// --- Destroy synchronization objects ---
 		for (auto fence : surfaceFences) {
@@ -212,6 +434,7 @@ namespace Vulkan {
 			}
 		}
 		surfaceFences.clear();
+		inFlightFences.clear();
 
 		for (auto semaphore : surfaceImageAvailableSemaphores) {
 			if (semaphore != VK_NULL_HANDLE) {
@@ -227,6 +450,63 @@ namespace Vulkan {
 		}
 		surfaceRenderFinishedSemaphores.clear();
 
+		// --- Destroy instance buffers and culling ---
+		for (auto* buffers : { &modelMatrixBuffers, &visibleInstanceBuffers, &instanceGroupBuffers, &drawCommandBuffers }) {
+			for (auto& buffer : *buffers) {
+				DestroyBuffer(vulkanCore, buffer);
+			}
+			buffers->clear();
+		}
+		DestroyBuffer(vulkanCore, meshBoundsBuffer);
+		pendingModelMatrixRanges.clear();
+
+		if (cullPipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(vulkanCore->vkDevice, cullPipeline, nullptr);
+			cullPipeline = VK_NULL_HANDLE;
+		}
+		if (cullPipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(vulkanCore->vkDevice, cullPipelineLayout, nullptr);
+			cullPipelineLayout = VK_NULL_HANDLE;
+		}
+
+		if (InstanceDescriptorResult.pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(vulkanCore->vkDevice, InstanceDescriptorResult.pool, nullptr);
+		}
+		if (InstanceDescriptorResult.layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(vulkanCore->vkDevice, InstanceDescriptorResult.layout, nullptr);
+		}
+		InstanceDescriptorResult = DescriptorResult{};
+
+		// --- Destroy composite ---
+		for (VulkanImage& image : sceneLayerImages) {
+			vkDestroyImageView(vulkanCore->vkDevice, image.view, nullptr);
+			vkDestroyImage(vulkanCore->vkDevice, image.image, nullptr);
+			vulkanCore->memoryAllocator->Free(image.allocation);
+		}
+		sceneLayerImages.clear();
+		freeSceneLayers.clear();
+		sceneLayerCount = 0;
+
+		if (surfacePipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(vulkanCore->vkDevice, surfacePipeline, nullptr);
+			surfacePipeline = VK_NULL_HANDLE;
+		}
+		if (surfacePipelineLayout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(vulkanCore->vkDevice, surfacePipelineLayout, nullptr);
+			surfacePipelineLayout = VK_NULL_HANDLE;
+		}
+		if (SurfaceDescriptorResult.pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(vulkanCore->vkDevice, SurfaceDescriptorResult.pool, nullptr);
+		}
+		if (SurfaceDescriptorResult.layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(vulkanCore->vkDevice, SurfaceDescriptorResult.layout, nullptr);
+		}
+		SurfaceDescriptorResult = DescriptorResult{};
+		if (offscreenSampler != VK_NULL_HANDLE) {
+			vkDestroySampler(vulkanCore->vkDevice, offscreenSampler, nullptr);
+			offscreenSampler = VK_NULL_HANDLE;
+		}
+
 		// --- Destroy framebuffers ---
 		for (auto framebuffer : surfaceFrameBuffers) {
 			if (framebuffer != VK_NULL_HANDLE) {
@@ -254,58 +534,78 @@ namespace Vulkan {
 		}
 	}
 
-	void VulkanSurface::CreateEmptyStartingDescriptors(std::shared_ptr<VulkanCore> VC, uint32_t arraySize)
+	void VulkanSurface::RefreshSurfaceDescriptors(std::shared_ptr<VulkanCore> vulkanCore, uint32_t frame)
 	{
-		descriptorSetInfo.bindings.clear();
-		descriptorSetInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
-
-		DescriptorBindingInfo bindinginfo{};
-		bindinginfo.binding = 0;
-		bindinginfo.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		bindinginfo.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		bindinginfo.count = 0;
-		descriptorSetInfo.bindings.push_back(bindinginfo);
-
-		DescriptorBindingInfo& binding = descriptorSetInfo.bindings[0];
+		if (!staleSurfaceDescriptors[frame])
+			return;
+		UpdateDescriptorSet(vulkanCore, descriptorSetInfo, SurfaceDescriptorResult, frame);
+		staleSurfaceDescriptors[frame] = false;
+	}
 
-		for (int i = 0; i < arraySize; i++)
+	void VulkanSurface::CreateInstanceResources(std::shared_ptr<VulkanCore> VC, uint32_t initialInstanceCapacity)
+	{
+		const uint32_t initialGroupCapacity = 64;
+		const uint32_t initialMeshCapacity = 64;
+
+		modelMatrixBuffers.clear();
+		visibleInstanceBuffers.clear();
+		instanceGroupBuffers.clear();
+		drawCommandBuffers.clear();
+		//Fresh buffers hold nothing, so the first sync of each frame copies every instance
+		pendingModelMatrixRanges.assign(MAX_FRAMES_IN_FLIGHT, { DirtyRange{ 0, UINT32_MAX } });
+
+		meshBoundsBuffer = CreateMappedStorageBuffer(VC, sizeof(glm::vec4) * initialMeshCapacity);
+
+		instanceSetInfo.bindings.clear();
+		instanceSetInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+		instanceSetInfo.bindings.push_back({ ModelMatrixBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT });
+		instanceSetInfo.bindings.push_back({ VisibleInstanceBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT });
+		instanceSetInfo.bindings.push_back({ MeshBoundsBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+		instanceSetInfo.bindings.push_back({ InstanceGroupBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+		instanceSetInfo.bindings.push_back({ DrawCommandBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT });
+
+		auto wholeBuffer = [](const VulkanBuffer& buffer)
 		{
-			// --- 1. Create offscreen images for each frame in flight ---
-			std::vector<VulkanImage> newSceneImages = initImageByType(
-				*VC,
-				ImageType::Color,
-				1,
-				1,
-				MAX_FRAMES_IN_FLIGHT,
-				VK_SAMPLE_COUNT_1_BIT,
-				VK_FORMAT_UNDEFINED
-			);
+			VkDescriptorBufferInfo info{};
+			info.buffer = buffer.buffer;
+			info.offset = 0;
+			info.range = VK_WHOLE_SIZE;
+			return info;
+		};
+
+		for (int frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+			modelMatrixBuffers.push_back(CreateMappedStorageBuffer(VC, sizeof(glm::mat4) * initialInstanceCapacity));
+			visibleInstanceBuffers.push_back(CreateStorageBuffer(VC, sizeof(uint32_t) * initialInstanceCapacity));
+			instanceGroupBuffers.push_back(CreateMappedStorageBuffer(VC, sizeof(InstanceGroup) * initialGroupCapacity));
+			drawCommandBuffers.push_back(CreateMappedStorageBuffer(VC, sizeof(VkDrawIndirectCommand) * initialGroupCapacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT));
+
+			instanceSetInfo.bindings[ModelMatrixBinding].buffers.push_back(wholeBuffer(modelMatrixBuffers[frame]));
+			instanceSetInfo.bindings[VisibleInstanceBinding].buffers.push_back(wholeBuffer(visibleInstanceBuffers[frame]));
+			instanceSetInfo.bindings[MeshBoundsBinding].buffers.push_back(wholeBuffer(meshBoundsBuffer));
+			instanceSetInfo.bindings[InstanceGroupBinding].buffers.push_back(wholeBuffer(instanceGroupBuffers[frame]));
+			instanceSetInfo.bindings[DrawCommandBinding].buffers.push_back(wholeBuffer(drawCommandBuffers[frame]));
+		}
 
-			for (auto& img : newSceneImages) {
-				TransitionImageLayout(
-					VC,
-					img.image,
-					img.format,
-					VK_IMAGE_LAYOUT_UNDEFINED,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-					VK_IMAGE_ASPECT_COLOR_BIT
-				);
-			}
+		InstanceDescriptorResult = CreateDescriptors(VC, instanceSetInfo);
 
-			dummyImages.push_back(newSceneImages);
+		// --- Cull pipeline ---
+		PipelineLayoutInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.setLayouts.push_back(InstanceDescriptorResult.layout);
 
-			for (int frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
-				VkDescriptorImageInfo info{};
-				info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				info.imageView = newSceneImages[frame].view;
-				info.sampler = offscreenSampler;
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(CullPushConstants);
+		pipelineLayoutInfo.pushConstants.push_back(pushConstantRange);
 
-				binding.images.push_back(info);
-			}
-		}
-		binding.count = static_cast<uint32_t>(binding.images.size());
+		cullPipelineLayout = CreatePipelineLayout(VC, pipelineLayoutInfo);
+		cullPipeline = CreateComputePipeline(
+			VC,
+			std::filesystem::current_path().string() + "/.." + "/Clever_Engine/Vulkan/res/cull.spv",
+			cullPipelineLayout
+		);
 
-		SurfaceDescriptorResult = CreateDescriptors(VC, descriptorSetInfo);
+		CreateCommandBuffers(VC, surfaceCommandPool, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), surfaceCullCommandBuffers);
 	}
 
 	void VulkanScene::CreateSceneResources(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface)
@@ -313,10 +613,6 @@ namespace Vulkan {
 		MAX_FRAMES_IN_FLIGHT = &vulkanSurface->MAX_FRAMES_IN_FLIGHT;
 		imageFrameCounter = &vulkanSurface->imageFrameCounter;
 
-		sceneIndex = vulkanSurface->AddNewScene(vulkanCore, width, height);
-
-		sceneColorImage = vulkanSurface->offscreenImages[sceneIndex];
-
 		sceneRenderPass = CreateRenderPass(
 			vulkanCore,
 			VK_FORMAT_B8G8R8A8_UNORM,
@@ -325,15 +621,7 @@ namespace Vulkan {
 			RenderPassType::Offscreen
 		);
 
-		CreateFrameBuffers(
-			vulkanCore,
-			sceneRenderPass,
-			*sceneColorImage,
-			{ scenedepthAttachment },
-			sceneOffscreenFrameBuffers,
-			width,
-			height
-		);
+		CreateLayerTargets(vulkanCore, vulkanSurface);
 
 		sceneCommandPool = CreateCommandPool(vulkanCore);
 
@@ -347,7 +635,14 @@ namespace Vulkan {
 		//descriptorResult = CreateDescriptors(vulkanCore, info);
 
 		PipelineLayoutInfo pipelineLayoutInfo{};
-		//pipelineLayoutInfo.setLayouts.push_back(descriptorResult.layout);
+		//Set 0 is the surface's per frame instance data, the push constant is the view projection
+		pipelineLayoutInfo.setLayouts.push_back(vulkanSurface->InstanceDescriptorResult.layout);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(glm::mat4);
+		pipelineLayoutInfo.pushConstants.push_back(pushConstantRange);
 		scenePipelineLayouts.push_back(CreatePipelineLayout(vulkanCore, pipelineLayoutInfo));
 
 		PipelineInfo pipelineInfo{};
@@ -358,13 +653,32 @@ namespace Vulkan {
 		pipelineInfo.bindingDescription = Vertex::getBindingDescription();
 		pipelineInfo.attributeDescriptions = Vertex::getAttributeDescriptions();
 		scenePipelines.push_back(CreateGraphicsPipeline(vulkanCore, pipelineInfo));
+		// No sync objects of its own, the scene's pass is submitted with the rest of the window's frame under the surface's fence
+	}
 
-		CreateSyncObjects(
+	void VulkanScene::CreateLayerTargets(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface)
+	{
+		// Frames in flight may still render through the old ones
+		for (VkFramebuffer framebuffer : sceneOffscreenFrameBuffers) {
+			vulkanSurface->deletionQueue.Push(framebuffer);
+		}
+		for (VkImageView view : sceneLayerViews) {
+			vulkanSurface->deletionQueue.Push(view);
+		}
+		sceneLayerViews.clear();
+
+		for (const VulkanImage& layerImage : vulkanSurface->sceneLayerImages) {
+			sceneLayerViews.push_back(createImageView(*vulkanCore, layerImage.image, layerImage.format, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_2D, 1, sceneLayer));
+		}
+
+		// The layer can be bigger than the scene, the framebuffer only covers the scene's corner of it
+		CreateFrameBuffers(
 			vulkanCore,
-			*MAX_FRAMES_IN_FLIGHT,
-			sceneImageAvailableSemaphores,
-			sceneRenderFinishedSemaphores,
-			sceneFences
+			sceneRenderPass,
+			sceneLayerViews,
+			sceneOffscreenFrameBuffers,
+			width,
+			height
 		);
 	}
 
@@ -375,79 +689,36 @@ namespace Vulkan {
 		xoffset = newX;
 		yoffset = newY;
 
-		VkDevice device = vulkanCore->vkDevice;
-
-		VulkanSurface& vulkanSurface = *vulkanSurfacePtr;
-
-		for (size_t i = 0; i < sceneFences.size(); ++i) {
-			vkWaitForFences(device, 1, &sceneFences[i], VK_TRUE, UINT64_MAX);
-		}
+		// The layer stays the same, only the framebuffers change size. The caller fits the surface's layers to the new size first
+		CreateLayerTargets(vulkanCore, vulkanSurfacePtr);
+	}
 
-		for (auto& fb : sceneOffscreenFrameBuffers) {
-			vkDestroyFramebuffer(device, fb, nullptr);
+	void VulkanScene::Destroy(VulkanSurface* vulkanSurface)
+	{
+		DeletionQueue& deletionQueue = vulkanSurface->deletionQueue;
+		for (VkFramebuffer framebuffer : sceneOffscreenFrameBuffers) {
+			deletionQueue.Push(framebuffer);
 		}
-		for (auto& img : *sceneColorImage) {
-			vkDestroyImageView(device, img.view, nullptr);
-			vkDestroyImage(device, img.image, nullptr);
-			vkFreeMemory(device, img.memory, nullptr);
+		sceneOffscreenFrameBuffers.clear();
+		for (VkImageView view : sceneLayerViews) {
+			deletionQueue.Push(view);
 		}
-
-		std::vector<VulkanImage> newSceneImages = initImageByType(
-			*vulkanCore,
-			ImageType::Color,
-			width,
-			height,
-			*MAX_FRAMES_IN_FLIGHT,
-			VK_SAMPLE_COUNT_1_BIT,
-			VK_FORMAT_UNDEFINED
-		);
-
-		for (auto& img : newSceneImages) {
-			TransitionImageLayout(
-				vulkanCore,
-				img.image,
-				img.format,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				VK_IMAGE_ASPECT_COLOR_BIT
-			);
+		sceneLayerViews.clear();
+		for (VkPipeline pipeline : scenePipelines) {
+			deletionQueue.Push(pipeline);
 		}
-
-		std::shared_ptr<std::vector<VulkanImage>> newSceneImagesPtr = std::make_shared<std::vector<VulkanImage>>(std::move(newSceneImages));
-		
-		vulkanSurface.offscreenImages.at(sceneIndex) = newSceneImagesPtr;
-		sceneColorImage = vulkanSurface.offscreenImages[sceneIndex];
-
-		DescriptorBindingInfo& binding = vulkanSurface.descriptorSetInfo.bindings[0];
-
-		// --- 3. Append new scene images to the existing binding ---
-		for (uint32_t frame = 0; frame < *MAX_FRAMES_IN_FLIGHT; ++frame)
-		{
-			VkDescriptorImageInfo info{};
-			info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			info.imageView = vulkanSurface.offscreenImages[sceneIndex]->at(frame).view;
-			info.sampler = vulkanSurface.offscreenSampler;
-
-			binding.images[(sceneIndex * *MAX_FRAMES_IN_FLIGHT) + frame] = info;
+		scenePipelines.clear();
+		for (VkPipelineLayout pipelineLayout : scenePipelineLayouts) {
+			deletionQueue.Push(pipelineLayout);
 		}
-
-		// Update descriptor count to match total number of images per frame
-		binding.count = static_cast<uint32_t>(binding.images.size());
-
-		// --- 4. Set maxSets ---
-		vulkanSurface.descriptorSetInfo.maxSets = *MAX_FRAMES_IN_FLIGHT;
-
-		UpdateDescriptorSets(vulkanCore, vulkanSurface.descriptorSetInfo, vulkanSurface.SurfaceDescriptorResult);
-
-		CreateFrameBuffers(
-			vulkanCore,
-			sceneRenderPass,
-			*sceneColorImage,
-			{ scenedepthAttachment },
-			sceneOffscreenFrameBuffers,
-			width,
-			height
-		);
+		scenePipelineLayouts.clear();
+		deletionQueue.Push(sceneRenderPass);
+		sceneRenderPass = VK_NULL_HANDLE;
+		deletionQueue.Push(sceneCommandPool);
+		sceneCommandPool = VK_NULL_HANDLE;
+		sceneCommandBuffers.clear();
+
+		vulkanSurface->ReleaseSceneLayer(sceneLayer);
 	}
 
 	void VulkanScene::UpdateSceneSurface(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface)
@@ -20,6 +20,10 @@ namespace Vulkan {
 	{
 		std::optional<uint32_t> graphicsIndex;
 		std::optional<uint32_t> presentIndex;
+		//Unset when there is no queue next to the graphics one to upload with
+		std::optional<uint32_t> transferIndex;
+		uint32_t transferQueueIndex = 0;
+		bool supportsTimelineSemaphores = false;
 
 		std::string deviceName = "Undefined";
 
@@ -55,9 +59,24 @@ namespace Vulkan {
 		}
 	};
 
+	class MemoryPool;
+	class MemoryAllocator;
+	class AsyncUploader;
+	struct VulkanCore;
+
+	//A range of device memory handed out by the MemoryAllocator, memory and offset are what gets bound
+	struct MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;        // What the allocator reserved, can be more than was asked for
+		void* mapped = nullptr;       // Already offset, set when the memory is host visible
+		MemoryPool* pool = nullptr;   // Null for dedicated allocations
+		uint32_t page = 0;
+	};
+
 	struct VulkanImage {
 		VkImage image;
-		VkDeviceMemory memory;
+		MemoryAllocation allocation;
 		VkImageView view;
 
 		VkFormat format = VK_FORMAT_UNDEFINED;
@@ -65,20 +84,64 @@ namespace Vulkan {
 		VkImageLayout currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		VkDeviceSize size = 0; // optional
 
-		void Destory(VkDevice& device) {
-			if (view != VK_NULL_HANDLE) {
-				vkDestroyImageView(device, view, nullptr);
-				view = VK_NULL_HANDLE;
-			}
-			if (image != VK_NULL_HANDLE) {
-				vkDestroyImage(device, image, nullptr);
-				image = VK_NULL_HANDLE;
-			}
-			if (memory != VK_NULL_HANDLE) {
-				vkFreeMemory(device, memory, nullptr);
-				memory = VK_NULL_HANDLE;
-			}
-		}
+		void Destory(VulkanCore& vulkanCore);
+	};
+
+	struct VulkanBuffer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		MemoryAllocation allocation;
+		VkDeviceSize size = 0;
+		VkDeviceSize capacity = 0;
+		void* mapped = nullptr; // Set for host visible buffers, points into the allocator's persistently mapped page
+	};
+
+	/*
+	GPU objects that were replaced while frames in flight may still use them.
+	Everything pushed is tagged with the frame being prepared and destroyed once that frame's fence has signalled,
+	so resizing and growing never have to wait on the device.
+	*/
+	class DeletionQueue {
+		public:
+			//uploadValue is an AsyncUploader value that has to be reached as well, for buffers uploads may still write to
+			void Push(const VulkanBuffer& buffer, uint64_t uploadValue = 0);
+			void Push(const VulkanImage& image);
+			void Push(VkImageView view);
+			void Push(VkFramebuffer framebuffer);
+			void Push(VkSwapchainKHR swapchain);
+			void Push(VkPipeline pipeline);
+			void Push(VkPipelineLayout pipelineLayout);
+			void Push(VkRenderPass renderPass);
+			//Frees the pool's command buffers with it
+			void Push(VkCommandPool commandPool);
+			//Raw memory that did not come from the MemoryAllocator
+			void Push(VkDeviceMemory memory);
+
+			//Call right after waiting on the fence of the frame being prepared
+			void Collect(VulkanCore& vulkanCore, uint32_t framesInFlight);
+			//Call once a frame has been submitted
+			void EndFrame() { ++frameNumber; }
+			//Destroys everything, the device has to be idle
+			void Flush(VulkanCore& vulkanCore);
+		private:
+			struct Entry {
+				uint64_t frameNumber = 0;
+				uint64_t uploadValue = 0;
+				VkFramebuffer framebuffer = VK_NULL_HANDLE;
+				VkImageView view = VK_NULL_HANDLE;
+				VkImage image = VK_NULL_HANDLE;
+				VkBuffer buffer = VK_NULL_HANDLE;
+				MemoryAllocation allocation{};
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+				VkPipeline pipeline = VK_NULL_HANDLE;
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				VkRenderPass renderPass = VK_NULL_HANDLE;
+				VkCommandPool commandPool = VK_NULL_HANDLE;
+			};
+			void Destroy(VulkanCore& vulkanCore, Entry& entry);
+
+			std::vector<Entry> entries{};
+			uint64_t frameNumber = 0; // Frames submitted so far, which is also the number of the frame being prepared
 	};
 
 	enum BufferTypes {
@@ -156,13 +219,73 @@ namespace Vulkan {
 		PhysicalDeviceData d_PhysicalDeviceData;
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue transferQueue = VK_NULL_HANDLE;
 		VkCommandPool coreCommandPool = VK_NULL_HANDLE;
 		VkCommandBuffer coreCommandBuffer = VK_NULL_HANDLE;
+		std::shared_ptr<MemoryAllocator> memoryAllocator;
+		std::shared_ptr<AsyncUploader> uploader; // Null without a transferQueue
 	};
 
 	struct SurfacePushConstants
 	{
-		int sceneIndex;
+		glm::vec2 uvScale; // Scene size over the scene layer size, a scene only covers the top left of its layer
+		int sceneLayer;
+	};
+
+	// Instances [first, first + count) whose model matrix changed since the last frame
+	struct DirtyRange
+	{
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	// Where a mesh's vertices sit in a window's shared mesh vertex buffer
+	struct MeshRange
+	{
+		uint32_t firstVertex = 0;
+		uint32_t vertexCount = 0;
+	};
+
+	// Instances [firstInstance, firstInstance + instanceCount) all use meshID and are drawn with one instanced draw
+	struct InstanceGroup
+	{
+		uint32_t meshID = 0;
+		uint32_t firstInstance = 0;
+		uint32_t instanceCount = 0;
+	};
+
+	// Per frame input from the engine, instance i's matrix is at modelMatrices + i * matrixStride bytes
+	struct InstanceFrameData
+	{
+		const void* modelMatrices = nullptr;
+		size_t matrixStride = sizeof(glm::mat4);
+		uint32_t instanceCount = 0;
+
+		const DirtyRange* dirtyRanges = nullptr;
+		uint32_t dirtyRangeCount = 0;
+
+		const InstanceGroup* groups = nullptr;
+		uint32_t groupCount = 0;
+
+		// Frustum the culling pass tests against, also applied by the scene vertex shader
+		glm::mat4 viewProjection{ 1.0f };
+	};
+
+	// Matches the push constants in cull.comp
+	struct CullPushConstants
+	{
+		glm::mat4 viewProjection;
+		uint32_t instanceCount;
+		uint32_t groupCount;
+	};
+
+	// Bindings of the surface's instance descriptor set, shared by the cull compute shader and the scene vertex shader
+	enum InstanceBindings : uint32_t {
+		ModelMatrixBinding = 0,     // mat4 per instance
+		VisibleInstanceBinding = 1, // Written by culling, per group the indices of its visible instances from firstInstance on
+		MeshBoundsBinding = 2,      // Local bounding sphere per mesh, xyz center and w radius
+		InstanceGroupBinding = 3,   // InstanceGroup per group
+		DrawCommandBinding = 4      // VkDrawIndirectCommand per group, culling counts the visible instances into it
 	};
 
 	class VulkanSurface {
@@ -172,6 +295,7 @@ namespace Vulkan {
 			SwapchainAttachmentType surfaceType = SwapchainAttachmentType::ColorDepth;
 
 			uint8_t imageFrameCounter = 0;//This will range from 0 to {MAX_FRAMES_IN_FLIGHT}
+			DeletionQueue deletionQueue{};
 			glm::uvec2 windowSize{0, 0};
 			GLFWwindow* p_GLFWWindow = nullptr;///////////////////////////////////////////////
 
@@ -191,21 +315,55 @@ namespace Vulkan {
 
 			std::vector<VkSemaphore> surfaceImageAvailableSemaphores{};
 			std::vector<VkSemaphore> surfaceRenderFinishedSemaphores{};
-			std::vector<VkFence> surfaceFences{};		
+			// Created signaled, they are what inFlightFences holds until a frame has been submitted
+			std::vector<VkFence> surfaceFences{};
+			// Fence of the submit that last carried each frame, one of surfaceFences or a FrameOrchestrator fence shared by every window
+			std::vector<VkFence> inFlightFences{};
 
 			DescriptorSetInfo descriptorSetInfo{};
 			DescriptorResult SurfaceDescriptorResult{};
+			// Frames whose surface descriptor set still points at replaced scene images, rewritten once the frame's fence has signalled
+			std::vector<bool> staleSurfaceDescriptors{};
+			// Frames whose scene layer image is new and still UNDEFINED, moved to SHADER_READ_ONLY by the frame's first command buffer
+			std::vector<bool> pendingSceneLayerTransitions{};
 
 			VkPipelineLayout surfacePipelineLayout = VK_NULL_HANDLE;
 			VkPipeline surfacePipeline = VK_NULL_HANDLE;
 
 			VkSampler offscreenSampler = VK_NULL_HANDLE;
 
-			std::vector<std::vector<VulkanImage>> dummyImages{};
-			std::vector<std::shared_ptr<std::vector<VulkanImage>>> offscreenImages{}; // Offscreen images for each frame in flight
-
-			int AddNewScene(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height);
-
+			// One persistently mapped storage buffer of model matrices per frame in flight, read through the visible instance list in the scene shader
+			std::vector<VulkanBuffer> modelMatrixBuffers{};
+			// Ranges each frame's buffer still has to copy, a frame only catches up when it is next recorded
+			std::vector<std::vector<DirtyRange>> pendingModelMatrixRanges{};
+
+			// GPU culling, per frame in flight except the mesh bounds, which are only appended to and replaced through the deletionQueue when they grow
+			std::vector<VulkanBuffer> visibleInstanceBuffers{};
+			std::vector<VulkanBuffer> instanceGroupBuffers{};
+			std::vector<VulkanBuffer> drawCommandBuffers{};
+			VulkanBuffer meshBoundsBuffer{};
+			// Recorded first in the frame's offscreen batch, also carries the staged uploads and scene layer transitions
+			std::vector<VkCommandBuffer> surfaceCullCommandBuffers{};
+			VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+			VkPipeline cullPipeline = VK_NULL_HANDLE;
+
+			// See InstanceBindings
+			DescriptorSetInfo instanceSetInfo{};
+			DescriptorResult InstanceDescriptorResult{};
+
+			// Every scene renders into a layer of one 2D array image per frame in flight, the composite samples all of them through one descriptor
+			std::vector<VulkanImage> sceneLayerImages{};
+			uint32_t sceneLayerCount = 0;
+			glm::uvec2 sceneLayerExtent{ 0, 0 };
+			std::vector<uint32_t> freeSceneLayers{};
+			static constexpr uint32_t InitialSceneLayerCount = 4;
+
+			// Hands out a free layer that fits width x height, growing the layer images when needed.
+			// Growing replaces them, imagesReplaced then means every other scene needs new targets
+			uint32_t AcquireSceneLayer(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height, bool& imagesReplaced);
+			void ReleaseSceneLayer(uint32_t layer);
+			// Grows the layers to at least width x height, true when that replaced the layer images
+			bool FitSceneLayers(std::shared_ptr<VulkanCore> vulkanCore, uint32_t width, uint32_t height);
 
 
 			void CreateSurfaceResources(std::shared_ptr<VulkanCore> vulkanCore, GLFWwindow* p_GLFWWindow);
@@ -213,8 +371,15 @@ namespace Vulkan {
 			void RecreateSwapchain(std::shared_ptr<VulkanCore> core);
 			// Destroy everything owned by the surface (waits device idle)
 			void Destroy(std::shared_ptr<VulkanCore> vulkanCore);
+			// Writes frame's surface descriptor set if the scene layer images were replaced since it was last written
+			void RefreshSurfaceDescriptors(std::shared_ptr<VulkanCore> vulkanCore, uint32_t frame);
+			bool HasPendingSceneLayerTransition(uint32_t frame) const { return pendingSceneLayerTransitions[frame]; }
+			// Moves every layer of frame's new scene layer image to SHADER_READ_ONLY, cmd has to run before the frame's scene passes
+			void RecordSceneLayerTransition(VkCommandBuffer cmd, uint32_t frame);
 		private:
-			void CreateEmptyStartingDescriptors(std::shared_ptr<VulkanCore> vulkanCore, uint32_t maxSets);
+			// Layers keep their contents only until the next frame renders them, so growing just makes new images
+			void CreateSceneLayers(std::shared_ptr<VulkanCore> vulkanCore, uint32_t layerCount, uint32_t width, uint32_t height);
+			void CreateInstanceResources(std::shared_ptr<VulkanCore> vulkanCore, uint32_t initialInstanceCapacity);
 	};
 
 	struct SceneInfo {
@@ -236,7 +401,7 @@ namespace Vulkan {
 			int32_t xoffset = 0;//Of Surface when comositing
 			int32_t yoffset = 0;//Of Surface when comositing
 
-			int sceneIndex = -1; // Index of the scene in the surface's offscreenImages vector
+			uint32_t sceneLayer = 0; // Layer of the surface's sceneLayerImages the scene renders into
 
 			int* MAX_FRAMES_IN_FLIGHT = nullptr; // Pointer to surface's max frames in flight 
 			uint8_t* imageFrameCounter = 0;
@@ -244,8 +409,8 @@ namespace Vulkan {
 			//Offscreen rendering
 			VkRenderPass sceneRenderPass = VK_NULL_HANDLE;
 		
-			std::shared_ptr<std::vector<VulkanImage>> sceneColorImage{};
-			std::vector<VulkanImage> scenedepthAttachment{};
+			// Per frame in flight, a view of sceneLayer in that frame's layer image
+			std::vector<VkImageView> sceneLayerViews{};
 
 			std::vector<VkFramebuffer>  sceneOffscreenFrameBuffers{};
 
@@ -258,19 +423,15 @@ namespace Vulkan {
 
 			DescriptorResult SceneDescriptorResult{};
 
-			std::vector<VkSemaphore> sceneImageAvailableSemaphores{};
-			std::vector<VkSemaphore> sceneRenderFinishedSemaphores{};
-			std::vector<VkFence> sceneFences{};
-
-			std::vector<Vertex> vertexData{};
-			std::vector<VulkanBuffer> sceneBuffers{};
-
 			std::vector<VulkanBuffer> uniformBuffers{};
 
+			// sceneLayer has to be acquired from the surface first
 			void CreateSceneResources(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface);
+			// Views and framebuffers of sceneLayer at the scene's size, the old ones go to the surface's deletionQueue
+			void CreateLayerTargets(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface);
 			void UpdateSceneSurface(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurface);
 			void ResizeScene(std::shared_ptr<VulkanCore> vulkanCore, VulkanSurface* vulkanSurfacePtr, uint32_t newWidth, uint32_t newHeight, uint32_t newX = 0, uint32_t newY = 0);
-			// Destroy everything owned by the scene (waits device idle)
-			void Destroy(VulkanCore& core);
+			// Hands everything owned by the scene to the surface's deletionQueue and frees its layer
+			void Destroy(VulkanSurface* vulkanSurface);
 	};
 }
\ No newline at end of file
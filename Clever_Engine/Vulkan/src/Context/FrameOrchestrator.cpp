@@ -0,0 +1,81 @@
+#include "FrameOrchestrator.h"
+
+#include <stdexcept>
+
+namespace Vulkan {
+	void FrameOrchestrator::Create(std::shared_ptr<VulkanCore> vc, uint32_t fenceCount)
+	{
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		fences.resize(fenceCount);
+		for (VkFence& fence : fences)
+		{
+			if (vkCreateFence(vc->vkDevice, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create frame fence!");
+		}
+	}
+
+	void FrameOrchestrator::Destroy(std::shared_ptr<VulkanCore> vc)
+	{
+		vkWaitForFences(vc->vkDevice, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX);
+		for (VkFence fence : fences)
+			vkDestroyFence(vc->vkDevice, fence, nullptr);
+		fences.clear();
+	}
+
+	void FrameOrchestrator::RenderFrame(std::shared_ptr<VulkanCore> vc, const std::vector<Window*>& windows, const InstanceFrameData& frameData, const Window::ParallelFor& parallelFor)
+	{
+		// --- 1. Record every window ---
+		begunWindows.clear();
+		for (Window* window : windows)
+		{
+			if (window->BeginFrame(frameData, parallelFor))
+				begunWindows.push_back(window);
+		}
+		if (begunWindows.empty())
+			return;
+
+		// --- 2. Submit all of them at once ---
+		submitInfos.clear();
+		for (Window* window : begunWindows)
+			window->AppendSubmitInfos(submitInfos);
+
+		// Frames of windows that still point at this fence from an earlier round end up waiting on this submit, later but never forever
+		VkFence fence = fences[nextFence];
+		nextFence = (nextFence + 1) % static_cast<uint32_t>(fences.size());
+		vkWaitForFences(vc->vkDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(vc->vkDevice, 1, &fence);
+
+		if (vkQueueSubmit(vc->graphicsQueue, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), fence) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit frame!");
+
+		// --- 3. Present every swapchain at once ---
+		swapchains.clear();
+		imageIndices.clear();
+		renderFinishedSemaphores.clear();
+		for (Window* window : begunWindows)
+		{
+			VulkanSurface& surface = window->vulkanSurface;
+			swapchains.push_back(surface.surfaceSwapChain);
+			imageIndices.push_back(window->GetAcquiredImageIndex());
+			renderFinishedSemaphores.push_back(surface.surfaceRenderFinishedSemaphores[surface.imageFrameCounter]);
+		}
+		presentResults.assign(begunWindows.size(), VK_SUCCESS);
+
+		VkPresentInfoKHR presentInfo{};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = static_cast<uint32_t>(renderFinishedSemaphores.size());
+		presentInfo.pWaitSemaphores = renderFinishedSemaphores.data();
+		presentInfo.swapchainCount = static_cast<uint32_t>(swapchains.size());
+		presentInfo.pSwapchains = swapchains.data();
+		presentInfo.pImageIndices = imageIndices.data();
+		// One window going out of date does not stop the others, each gets its own result
+		presentInfo.pResults = presentResults.data();
+		vkQueuePresentKHR(vc->presentQueue, &presentInfo);
+
+		for (size_t i = 0; i < begunWindows.size(); ++i)
+			begunWindows[i]->EndFrame(fence, presentResults[i]);
+	}
+}
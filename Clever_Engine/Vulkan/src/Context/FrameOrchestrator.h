@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <memory>
+
+#include "ContextVulkanData.h"
+#include "Window.h"
+
+namespace Vulkan {
+
+	/*
+	Renders a set of windows as one frame. Every window records its frame first, then all of them go out
+	in a single vkQueueSubmit and every acquired image in a single vkQueuePresentKHR.
+	The submit signals a fence of the orchestrator, each window waits on it through VulkanSurface::inFlightFences.
+	*/
+	class FrameOrchestrator
+	{
+	public:
+		void Create(std::shared_ptr<VulkanCore> vc, uint32_t fenceCount = 3);
+		void Destroy(std::shared_ptr<VulkanCore> vc);
+
+		//Windows whose frame can not begin, like one with an out of date swapchain, sit this frame out
+		void RenderFrame(std::shared_ptr<VulkanCore> vc, const std::vector<Window*>& windows, const InstanceFrameData& frameData, const Window::ParallelFor& parallelFor = {});
+	private:
+		std::vector<VkFence> fences{};
+		uint32_t nextFence = 0;
+
+		//Scratch, kept between frames so they stop allocating
+		std::vector<Window*> begunWindows{};
+		std::vector<VkSubmitInfo> submitInfos{};
+		std::vector<VkSwapchainKHR> swapchains{};
+		std::vector<uint32_t> imageIndices{};
+		std::vector<VkSemaphore> renderFinishedSemaphores{};
+		std::vector<VkResult> presentResults{};
+	};
+}
@@ -16,6 +16,8 @@
 #include "Scene/CreateDescriptors.h"
 #include "Scene/CreatePipelines.h"
 #include "Buffers/CreateBuffer.h"
+#include "Memory/MemoryAllocator.h"
+#include "Buffers/AsyncUploader.h"
 
 namespace Vulkan {
 	void VulkanContext::Init() {
@@ -24,10 +26,21 @@ namespace Vulkan {
 		CreateVulkanInstance(vulkanCore);
 		CreatePhysicalDevice(vulkanCore);
 		CreateLogicalDevice(vulkanCore);//This also makes the DebugUtilsMessengerEXT object and the graphics and present Queue
+		vulkanCore->memoryAllocator = std::make_shared<MemoryAllocator>(vulkanCore->vkDevice, vulkanCore->vkPhysicalDevice);
+		if (vulkanCore->transferQueue != VK_NULL_HANDLE)
+		{
+			vulkanCore->uploader = std::make_shared<AsyncUploader>(
+				vulkanCore->vkDevice,
+				vulkanCore->transferQueue,
+				vulkanCore->d_PhysicalDeviceData.transferIndex.value(),
+				vulkanCore->memoryAllocator
+			);
+		}
 		vulkanCore->coreCommandPool = CreateCommandPool(vulkanCore);
 		std::vector<VkCommandBuffer> dummy;
 		dummy.push_back(vulkanCore->coreCommandBuffer);
 		CreateCommandBuffers(vulkanCore, vulkanCore->coreCommandPool, 1, dummy);
+		frameOrchestrator.Create(vulkanCore);
 	}
 
 	void VulkanContext::Update()
@@ -48,6 +61,18 @@ namespace Vulkan {
 		}
 	}
 
+	void VulkanContext::Render(const InstanceFrameData& frameData, const Window::ParallelFor& parallelFor)
+	{
+		//Closed windows keep their entry until Update, but have no swapchain left
+		frameWindows.clear();
+		for (auto& [id, window] : windows)
+		{
+			if (window->vulkanSurface.surfaceSwapChain != VK_NULL_HANDLE)
+				frameWindows.push_back(window.get());
+		}
+		frameOrchestrator.RenderFrame(vulkanCore, frameWindows, frameData, parallelFor);
+	}
+
 	uint8_t VulkanContext::CreateNewWindow(SurfaceFlags flags)
 	{
 		std::shared_ptr<Window> renderSurface = std::make_shared<Window>(vulkanCore, flags, GetNextSurfaceID());
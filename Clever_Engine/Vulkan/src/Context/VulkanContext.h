@@ -4,10 +4,12 @@
 #include <stdexcept>
 #include <memory>
 #include <map>
+#include <vector>
 
 #include "ContextVulkanData.h"
 #include "Surface/SurfaceFlags.h"
 #include "Window.h"
+#include "FrameOrchestrator.h"
 
 
 namespace Vulkan 
@@ -24,6 +26,8 @@ namespace Vulkan
 		void Update();
 
 		uint8_t CreateNewWindow(SurfaceFlags flags);
+		//Renders every open window as one frame, with one submit and one present for all of them
+		void Render(const InstanceFrameData& frameData, const Window::ParallelFor& parallelFor = {});
 
 		//RETURNS NULLPTR if not found
 		inline std::shared_ptr<Window> GetWindow(uint8_t id)
@@ -38,5 +42,8 @@ namespace Vulkan
 
 		std::shared_ptr<VulkanCore> vulkanCore;
 		std::map<uint8_t, std::shared_ptr<Window>> windows;
+		FrameOrchestrator frameOrchestrator{};
+		//Scratch for Render
+		std::vector<Window*> frameWindows{};
 	};
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "Window.h"
 #include "Buffers/CreateBuffer.h"
+#include "Buffers/AsyncUploader.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 namespace Vulkan {
 	Window::Window(std::shared_ptr<VulkanCore> core, SurfaceFlags flags, uint8_t id) : 
@@ -18,28 +21,303 @@ namespace Vulkan {
 		}
 
         vulkanSurface.CreateSurfaceResources(vulkanCore, glfwWindowptr);
+        stagingRing.Create(vulkanCore, static_cast<uint32_t>(vulkanSurface.MAX_FRAMES_IN_FLIGHT));
+        UploadMeshBounds();
 		if (vulkanScenes.size() > 0) return;
 		//CREATING FIRST SCENE OF Window, might want to make a way to create a new Window without making a new scene
 
 	}
 	void Window::CloseWindow()
 	{
+        // Uploads can still be writing to buffers in the deletion queue the surface flushes
+        if (vulkanCore->uploader)
+            vulkanCore->uploader->WaitIdle();
+        for (auto& [sceneID, scene] : vulkanScenes)
+            scene->Destroy(&vulkanSurface);
+        vulkanScenes.clear();
         vulkanSurface.Destroy(vulkanCore);
+        DestroyBuffer(vulkanCore, meshVertexBuffer);
+        stagingRing.Destroy(vulkanCore);
 	}
 
-    void Window::SyncUniformObjectBuffer(std::unordered_map<uint32_t, Transform>& transforms)
+    void Window::SyncUniformObjectBuffer(const InstanceFrameData& frameData)
     {
-		//TODO update shader to have uniform buffer for model matrix
-		//Make this function loop over all models matrixe and check if dirty, if dirty update the buffer
+        uint32_t frame = vulkanSurface.imageFrameCounter;
+
+        // Every frame's buffer needs these changes, frames other than the current one copy them when they are next recorded
+        for (auto& pending : vulkanSurface.pendingModelMatrixRanges)
+        {
+            pending.insert(pending.end(), frameData.dirtyRanges, frameData.dirtyRanges + frameData.dirtyRangeCount);
+            if (pending.size() > MaxPendingModelMatrixRanges)
+            {
+                DirtyRange merged{ UINT32_MAX, 0 };
+                uint32_t end = 0;
+                for (const DirtyRange& range : pending)
+                {
+                    merged.first = std::min(merged.first, range.first);
+                    end = std::max(end, range.first + range.count);
+                }
+                merged.count = end - merged.first;
+                pending.assign(1, merged);
+            }
+        }
+
+        VulkanBuffer& buffer = vulkanSurface.modelMatrixBuffers[frame];
+        std::vector<DirtyRange>& pending = vulkanSurface.pendingModelMatrixRanges[frame];
+        VkDeviceSize requiredSize = sizeof(glm::mat4) * static_cast<VkDeviceSize>(frameData.instanceCount);
+
+        // --- Grow, the GPU is done with this frame's buffer so it can be replaced right away ---
+        if (requiredSize > buffer.capacity)
+        {
+            VkDeviceSize newCapacity = GrownCapacity(buffer.capacity, requiredSize);
+            DestroyBuffer(vulkanCore, buffer);
+            buffer = CreateMappedStorageBuffer(vulkanCore, newCapacity);
+            WriteInstanceDescriptor(frame, ModelMatrixBinding, buffer);
+
+            // New buffer has nothing in it yet
+            pending.assign(1, DirtyRange{ 0, frameData.instanceCount });
+        }
+
+        // --- Copy only the changed matrices, the memory is coherent so no flush is needed ---
+        const uint8_t* source = static_cast<const uint8_t*>(frameData.modelMatrices);
+        glm::mat4* destination = static_cast<glm::mat4*>(buffer.mapped);
+        for (const DirtyRange& range : pending)
+        {
+            uint32_t first = std::min(range.first, frameData.instanceCount);
+            uint32_t end = std::min(range.first + range.count, frameData.instanceCount);
+            if (first >= end)
+                continue;
+
+            if (frameData.matrixStride == sizeof(glm::mat4))
+            {
+                memcpy(destination + first, source + first * sizeof(glm::mat4), (end - first) * sizeof(glm::mat4));
+                continue;
+            }
+            for (uint32_t i = first; i < end; ++i)
+                memcpy(destination + i, source + i * frameData.matrixStride, sizeof(glm::mat4));
+        }
+
+        buffer.size = requiredSize;
+        pending.clear();
     }
-	
-    void Window::resizeScenes()
+
+    bool Window::PrepareCulling(const InstanceFrameData& frameData)
+    {
+        if (frameData.instanceCount == 0 || frameData.groupCount == 0 || meshVertexBuffer.buffer == VK_NULL_HANDLE)
+            return false;
+
+        uint32_t frame = vulkanSurface.imageFrameCounter;
+
+        // The mesh bounds buffer is shared, a frame only points its set at a replacement once it is no longer in flight
+        if (vulkanSurface.instanceSetInfo.bindings[MeshBoundsBinding].buffers[frame].buffer != vulkanSurface.meshBoundsBuffer.buffer)
+            WriteInstanceDescriptor(frame, MeshBoundsBinding, vulkanSurface.meshBoundsBuffer);
+
+        // --- Grow, like the model matrices the GPU is done with this frame's buffers ---
+        VulkanBuffer& visible = vulkanSurface.visibleInstanceBuffers[frame];
+        VkDeviceSize visibleSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(frameData.instanceCount);
+        if (visibleSize > visible.capacity)
+        {
+            VkDeviceSize newCapacity = GrownCapacity(visible.capacity, visibleSize);
+            DestroyBuffer(vulkanCore, visible);
+            visible = CreateStorageBuffer(vulkanCore, newCapacity);
+            WriteInstanceDescriptor(frame, VisibleInstanceBinding, visible);
+        }
+
+        VulkanBuffer& groups = vulkanSurface.instanceGroupBuffers[frame];
+        VkDeviceSize groupsSize = sizeof(InstanceGroup) * static_cast<VkDeviceSize>(frameData.groupCount);
+        if (groupsSize > groups.capacity)
+        {
+            VkDeviceSize newCapacity = GrownCapacity(groups.capacity, groupsSize);
+            DestroyBuffer(vulkanCore, groups);
+            groups = CreateMappedStorageBuffer(vulkanCore, newCapacity);
+            WriteInstanceDescriptor(frame, InstanceGroupBinding, groups);
+        }
+
+        VulkanBuffer& commands = vulkanSurface.drawCommandBuffers[frame];
+        VkDeviceSize commandsSize = sizeof(VkDrawIndirectCommand) * static_cast<VkDeviceSize>(frameData.groupCount);
+        if (commandsSize > commands.capacity)
+        {
+            VkDeviceSize newCapacity = GrownCapacity(commands.capacity, commandsSize);
+            DestroyBuffer(vulkanCore, commands);
+            commands = CreateMappedStorageBuffer(vulkanCore, newCapacity, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+            WriteInstanceDescriptor(frame, DrawCommandBinding, commands);
+        }
+
+        // --- One draw per group with no instances yet, culling counts them in ---
+        memcpy(groups.mapped, frameData.groups, static_cast<size_t>(groupsSize));
+        VkDrawIndirectCommand* drawCommands = static_cast<VkDrawIndirectCommand*>(commands.mapped);
+        for (uint32_t i = 0; i < frameData.groupCount; ++i)
+        {
+            const InstanceGroup& group = frameData.groups[i];
+            VkDrawIndirectCommand& command = drawCommands[i];
+            command = VkDrawIndirectCommand{};
+            command.firstInstance = group.firstInstance;
+
+            // Unknown meshes keep a vertex count of 0, which the cull shader also skips
+            if (group.meshID < meshes.size())
+            {
+                command.vertexCount = meshes[group.meshID].vertexCount;
+                command.firstVertex = meshes[group.meshID].firstVertex;
+            }
+        }
+
+        groups.size = groupsSize;
+        commands.size = commandsSize;
+        return true;
+    }
+
+    VkCommandBuffer Window::RecordTransfersAndCulling(const InstanceFrameData& frameData, bool cull, uint64_t& uploadWaitValue)
+    {
+        uint32_t frame = vulkanSurface.imageFrameCounter;
+        VkCommandBuffer cullCmd = vulkanSurface.surfaceCullCommandBuffers[frame];
+        vkResetCommandBuffer(cullCmd, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cullCmd, &beginInfo);
+
+        // Before anything in the frame renders into or samples the scene layers
+        vulkanSurface.RecordSceneLayerTransition(cullCmd, frame);
+
+        // --- Meshes drawn for the first time since their async upload make the GPU wait for it ---
+        uploadWaitValue = 0;
+        if (cull)
+        {
+            for (uint32_t i = 0; i < frameData.groupCount; ++i)
+            {
+                uint32_t meshID = frameData.groups[i].meshID;
+                if (meshID < meshUploadValues.size())
+                    uploadWaitValue = std::max(uploadWaitValue, meshUploadValues[meshID]);
+            }
+        }
+        bool waitForUploads = uploadWaitValue > waitedUploadValue;
+        if (waitForUploads)
+        {
+            // Chains the semaphore wait into every later command on this queue, later frames need no wait of their own
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(
+                cullCmd,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+            );
+            waitedUploadValue = uploadWaitValue;
+        }
+        else
+        {
+            uploadWaitValue = 0;
+        }
+
+        // Uploads go first so culling and every scene after it see them
+        stagingRing.RecordCopies(cullCmd, frame);
+
+        if (cull)
+            RecordCulling(cullCmd, frameData);
+
+        vkEndCommandBuffer(cullCmd);
+        return cullCmd;
+    }
+
+    void Window::RecordCulling(VkCommandBuffer cullCmd, const InstanceFrameData& frameData)
     {
-        for (VkFence fence : vulkanSurface.surfaceFences)
+        uint32_t frame = vulkanSurface.imageFrameCounter;
+        vkCmdBindPipeline(cullCmd, VK_PIPELINE_BIND_POINT_COMPUTE, vulkanSurface.cullPipeline);
+        vkCmdBindDescriptorSets(
+            cullCmd,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            vulkanSurface.cullPipelineLayout,
+            0, 1,
+            &vulkanSurface.InstanceDescriptorResult.sets[frame],
+            0, nullptr
+        );
+
+        CullPushConstants constants{};
+        constants.viewProjection = frameData.viewProjection;
+        constants.instanceCount = frameData.instanceCount;
+        constants.groupCount = frameData.groupCount;
+        vkCmdPushConstants(cullCmd, vulkanSurface.cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &constants);
+
+        // 64 matches local_size_x in cull.comp, which tests each instance like Vulkan::IsInstanceVisible
+        vkCmdDispatch(cullCmd, (frameData.instanceCount + 63) / 64, 1, 1);
+
+        // Scene submissions later on this queue read the draw counts and visible instances
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            cullCmd,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    void Window::UploadMeshBounds()
+    {
+        // Created with the surface, InitWindow uploads whatever was added before that
+        VulkanBuffer& buffer = vulkanSurface.meshBoundsBuffer;
+        if (buffer.buffer == VK_NULL_HANDLE || meshBounds.empty())
+            return;
+
+        VkDeviceSize requiredSize = sizeof(glm::vec4) * static_cast<VkDeviceSize>(meshBounds.size());
+        if (requiredSize > buffer.capacity)
         {
-            vkWaitForFences(vulkanCore->vkDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+            VkDeviceSize newCapacity = GrownCapacity(buffer.capacity, requiredSize);
+            vulkanSurface.deletionQueue.Push(buffer);
+            buffer = CreateMappedStorageBuffer(vulkanCore, newCapacity);
         }
 
+        memcpy(buffer.mapped, meshBounds.data(), static_cast<size_t>(requiredSize));
+        buffer.size = requiredSize;
+    }
+
+    uint32_t Window::BeginStagingFrame()
+    {
+        // Staging space of this frame is only reusable once its last submission finished, usually long done by now
+        uint32_t frame = vulkanSurface.imageFrameCounter;
+        vkWaitForFences(vulkanCore->vkDevice, 1, &vulkanSurface.inFlightFences[frame], VK_TRUE, UINT64_MAX);
+        stagingRing.BeginFrame(vulkanCore, frame);
+        return frame;
+    }
+
+    void Window::StageUpload(const VulkanBuffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+    {
+        stagingRing.Stage(vulkanCore, BeginStagingFrame(), dst.buffer, dstOffset, data, size);
+    }
+
+    VkDeviceSize Window::GrownCapacity(VkDeviceSize capacity, VkDeviceSize requiredSize) const
+    {
+        return std::max(requiredSize, static_cast<VkDeviceSize>(static_cast<double>(capacity) * bufferGrowthFactor));
+    }
+
+    void Window::WriteInstanceDescriptor(uint32_t frame, uint32_t binding, const VulkanBuffer& buffer)
+    {
+        VkDescriptorBufferInfo& info = vulkanSurface.instanceSetInfo.bindings[binding].buffers[frame];
+        info.buffer = buffer.buffer;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = vulkanSurface.InstanceDescriptorResult.sets[frame];
+        write.dstBinding = binding;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &info;
+        vkUpdateDescriptorSets(vulkanCore->vkDevice, 1, &write, 0, nullptr);
+    }
+	
+    void Window::resizeScenes()
+    {
         size_t sceneCount = vulkanScenes.size();
         if (sceneCount == 0) return;
 
@@ -52,16 +330,18 @@ namespace Vulkan {
 
         uint32_t sceneWidth = actualWidth / cols;
         uint32_t sceneHeight = actualHeight / rows;
+        vulkanSurface.FitSceneLayers(vulkanCore, sceneWidth, sceneHeight);
 
-        for (size_t i = 0; i < sceneCount; ++i)
+        size_t i = 0;
+        for (auto& [sceneID, scene] : vulkanScenes)
         {
-            auto& scene = vulkanScenes[i];
             scene->width = sceneWidth;
             scene->height = sceneHeight;
             // Optionally, you can also set position if needed
             scene->xoffset = (i % cols) * sceneWidth;
             scene->yoffset = (i / cols) * sceneHeight;
             scene->ResizeScene(vulkanCore, &vulkanSurface, sceneWidth, sceneHeight, scene->xoffset, scene->yoffset);
+            ++i;
         }
     }
 
@@ -83,29 +363,197 @@ namespace Vulkan {
         scenePtr->yoffset = posy;
 
         // --- 3. Create Vulkan resources ---
+        bool layersReplaced = false;
+        scenePtr->sceneLayer = vulkanSurface.AcquireSceneLayer(vulkanCore, width, height, layersReplaced);
+        if (layersReplaced)
+        {
+            for (auto& [sceneID, scene] : vulkanScenes)
+                scene->CreateLayerTargets(vulkanCore, &vulkanSurface);
+        }
         scenePtr->CreateSceneResources(vulkanCore, &vulkanSurface);
 
         // --- 4. Add to scene list ---
         vulkanScenes.insert({ scenePtr->sceneID, scenePtr });
 
-		// Add the object's vertices to the scene's vertex data
-        //Right now only can render a triangle
-        //When asset manager is made replace this
-        scenePtr->vertexData.push_back(Vertex{glm::vec3(1.0f, 1.0f, 0.0f)});
-        scenePtr->vertexData.push_back(Vertex{ glm::vec3(-1.0f, -1.0f, 0.0f) });
-        scenePtr->vertexData.push_back(Vertex{ glm::vec3(1.0f, -1.0f, 0.0f) });
-
-        //9 is the initial overestimation of vertices, grows by x2 when overflowed
-		scenePtr->sceneBuffers.push_back(CreateVertexBuffer(vulkanCore, sizeof(Vertex) * 9));
-        
-
         // --- 5. Return the scene ID ---
         return scenePtr->sceneID;
     }
 
-    void Window::RenderScenes(std::unordered_map<uint32_t, Transform>& transforms)
+    void Window::RemoveScene(uint8_t sceneID)
     {
+        auto it = vulkanScenes.find(sceneID);
+        if (it == vulkanScenes.end())
+            return;
+        // Nothing else changes, its layer just sits unused in the layer images until the next scene takes it
+        it->second->Destroy(&vulkanSurface);
+        vulkanScenes.erase(it);
+    }
 
+    uint32_t Window::CreateMesh(const std::vector<Vertex>& vertices)
+    {
+        if (vertices.empty())
+            throw std::runtime_error("Cannot create a mesh without vertices!");
+
+        MeshRange mesh{};
+        mesh.firstVertex = static_cast<uint32_t>(meshVertices.size());
+        mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+        meshVertices.insert(meshVertices.end(), vertices.begin(), vertices.end());
+        meshes.push_back(mesh);
+
+        // Sphere around the bounding box, loose but cheap to test
+        glm::vec3 minimum = vertices[0].pos;
+        glm::vec3 maximum = vertices[0].pos;
+        for (const Vertex& vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.pos);
+            maximum = glm::max(maximum, vertex.pos);
+        }
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        float radius = 0.0f;
+        for (const Vertex& vertex : vertices)
+            radius = std::max(radius, glm::length(vertex.pos - center));
+        meshBounds.push_back(glm::vec4(center, radius));
+
+        VkDeviceSize requiredSize = sizeof(Vertex) * static_cast<VkDeviceSize>(meshVertices.size());
+        VkDeviceSize meshOffset = sizeof(Vertex) * static_cast<VkDeviceSize>(mesh.firstVertex);
+        VkDeviceSize meshSize = sizeof(Vertex) * static_cast<VkDeviceSize>(mesh.vertexCount);
+        //64 is the initial overestimation of vertices
+        VkDeviceSize capacityNeeded = std::max(requiredSize, static_cast<VkDeviceSize>(sizeof(Vertex) * 64));
+
+        // Growing never waits, the old buffer goes to the deletion queue until the frames drawing from it and the uploads writing to it are done
+        uint64_t previousUploadValue = meshUploadValues.empty() ? 0 : *std::max_element(meshUploadValues.begin(), meshUploadValues.end());
+        if (vulkanCore->uploader)
+        {
+            if (capacityNeeded > meshVertexBuffer.capacity)
+            {
+                // The transfer queue can not copy the old contents in order with the frames, every mesh goes up again instead
+                if (meshVertexBuffer.buffer != VK_NULL_HANDLE)
+                    vulkanSurface.deletionQueue.Push(meshVertexBuffer, previousUploadValue);
+                meshVertexBuffer = CreateVertexBuffer(vulkanCore, GrownCapacity(meshVertexBuffer.capacity, capacityNeeded));
+                meshUploadValues.assign(meshes.size(), vulkanCore->uploader->Upload(meshVertexBuffer.buffer, 0, meshVertices.data(), requiredSize));
+            }
+            else
+            {
+                meshUploadValues.push_back(vulkanCore->uploader->Upload(meshVertexBuffer.buffer, meshOffset, vertices.data(), meshSize));
+            }
+        }
+        else
+        {
+            uint32_t frame = BeginStagingFrame();
+            EnsureCapacityDeferred(
+                vulkanCore,
+                stagingRing,
+                frame,
+                meshVertexBuffer,
+                capacityNeeded,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                bufferGrowthFactor,
+                vulkanSurface.deletionQueue
+            );
+            stagingRing.Stage(vulkanCore, frame, meshVertexBuffer.buffer, meshOffset, vertices.data(), meshSize);
+            meshUploadValues.push_back(0);
+        }
+        meshVertexBuffer.size = requiredSize;
+        UploadMeshBounds();
+
+        return static_cast<uint32_t>(meshes.size()) - 1;
+    }
+
+    VkCommandBuffer Window::RecordScene(VulkanScene& scene, const InstanceFrameData& frameData, bool drawInstances)
+    {
+        VkCommandBuffer sceneCmd = scene.sceneCommandBuffers[*scene.imageFrameCounter];
+        vkResetCommandBuffer(sceneCmd, 0);
+
+        // Begin offscreen command buffer
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(sceneCmd, &beginInfo);
+
+        // Offscreen render pass
+        VkRenderPassBeginInfo offscreenPassInfo{};
+        offscreenPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        offscreenPassInfo.renderPass = scene.sceneRenderPass;
+        offscreenPassInfo.framebuffer = scene.sceneOffscreenFrameBuffers[*scene.imageFrameCounter];
+        offscreenPassInfo.renderArea.offset = { 0, 0 };
+        offscreenPassInfo.renderArea.extent = { scene.width, scene.height };
+
+        VkClearValue clearValues[2];
+        clearValues[0].color = SceneClearColor;
+        clearValues[1].depthStencil = { 1.0f, 0 };
+        offscreenPassInfo.clearValueCount = 2;
+        offscreenPassInfo.pClearValues = clearValues;
+
+        vkCmdBeginRenderPass(sceneCmd, &offscreenPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{
+            0.0f,
+            0.0f,
+            static_cast<float>(scene.width),
+            static_cast<float>(scene.height),
+            0.0f, 1.0f };
+        vkCmdSetViewport(sceneCmd, 0, 1, &viewport);
+
+        VkRect2D scissor{ {0,0}, {scene.width, scene.height} };
+        vkCmdSetScissor(sceneCmd, 0, 1, &scissor);
+
+        RecordSceneDraws(sceneCmd, scene, frameData, drawInstances);
+
+        vkCmdEndRenderPass(sceneCmd);
+
+        vkEndCommandBuffer(sceneCmd);
+        return sceneCmd;
+    }
+
+    void Window::RecordSceneDraws(VkCommandBuffer sceneCmd, VulkanScene& scene, const InstanceFrameData& frameData, bool drawInstances)
+    {
+        vkCmdBindPipeline(sceneCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, scene.scenePipelines[0]);
+        vkCmdBindDescriptorSets(
+            sceneCmd,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            scene.scenePipelineLayouts[0],
+            0, 1,
+            &vulkanSurface.InstanceDescriptorResult.sets[vulkanSurface.imageFrameCounter],
+            0, nullptr
+        );
+        vkCmdPushConstants(sceneCmd, scene.scenePipelineLayouts[0], VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &frameData.viewProjection);
+
+        // One indirect draw per mesh group, culling has filled in how many of its instances are visible
+        if (drawInstances)
+        {
+            VkBuffer vertexBuffers[] = { meshVertexBuffer.buffer };
+            VkDeviceSize offsets[] = { 0 };
+            vkCmdBindVertexBuffers(sceneCmd, 0, 1, vertexBuffers, offsets);
+            vkCmdDrawIndirect(
+                sceneCmd,
+                vulkanSurface.drawCommandBuffers[vulkanSurface.imageFrameCounter].buffer,
+                0,
+                frameData.groupCount,
+                sizeof(VkDrawIndirectCommand)
+            );
+        }
+    }
+
+    VulkanScene* Window::DirectScene() const
+    {
+        if (vulkanScenes.size() != 1)
+            return nullptr;
+
+        VulkanScene* scene = vulkanScenes.begin()->second.get();
+        if (!scene)
+            return nullptr;
+
+        bool coversWindow =
+            scene->xoffset <= 0 &&
+            scene->yoffset <= 0 &&
+            scene->xoffset + static_cast<int64_t>(scene->width) >= static_cast<int64_t>(vulkanSurface.windowSize.x) &&
+            scene->yoffset + static_cast<int64_t>(scene->height) >= static_cast<int64_t>(vulkanSurface.windowSize.y);
+        return coversWindow ? scene : nullptr;
+    }
+
+    bool Window::BeginFrame(const InstanceFrameData& frameData, const ParallelFor& parallelFor)
+    {
         // --- 0. Update window size ---
         int width, height;
         glfwGetWindowSize(vulkanSurface.p_GLFWWindow, &width, &height);
@@ -121,115 +569,69 @@ namespace Vulkan {
         }
 
         // --- 2. Wait for fence for this frame ---
-        VkFence frameFence = vulkanSurface.surfaceFences[vulkanSurface.imageFrameCounter];
-        vkWaitForFences(device, 1, &frameFence, VK_TRUE, UINT64_MAX);
-        vkResetFences(device, 1, &frameFence);
+        vkWaitForFences(device, 1, &vulkanSurface.inFlightFences[vulkanSurface.imageFrameCounter], VK_TRUE, UINT64_MAX);
+        vulkanSurface.deletionQueue.Collect(*vulkanCore, static_cast<uint32_t>(vulkanSurface.MAX_FRAMES_IN_FLIGHT));
+        vulkanSurface.RefreshSurfaceDescriptors(vulkanCore, vulkanSurface.imageFrameCounter);
+
+        // Safe to write this frame's model matrices now, done before acquiring so a skipped frame still catches up
+        SyncUniformObjectBuffer(frameData);
 
         // --- 3. Acquire next swapchain image ---
-        uint32_t swapchainImageIndex;
         VkResult acquireResult = vkAcquireNextImageKHR(
             device,
             vulkanSurface.surfaceSwapChain,
             UINT64_MAX,
             vulkanSurface.surfaceImageAvailableSemaphores[vulkanSurface.imageFrameCounter],
             VK_NULL_HANDLE,
-            &swapchainImageIndex
+            &acquiredImageIndex
         );
 
         if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR || acquireResult == VK_SUBOPTIMAL_KHR)
         {
             needsToBeRecreated = true;
-            return;
+            return false;
         }
         else if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
         {
             throw std::runtime_error("Failed to acquire swapchain image!");
         }
 
-        // --- 4. Render each scene to offscreen framebuffer ---
-        std::vector<VkSemaphore> sceneFinishedSemaphores;
-        for (auto& [sceneID, scene] : vulkanScenes)
-        {
-            if (!scene) continue;
-            VkCommandBuffer sceneCmd = scene->sceneCommandBuffers[*scene->imageFrameCounter];
-            VkFence sceneFence = scene->sceneFences[*scene->imageFrameCounter];
-
-            vkWaitForFences(device, 1, &sceneFence, VK_TRUE, UINT64_MAX);
-            vkResetFences(device, 1, &sceneFence);
-            vkResetCommandBuffer(sceneCmd, 0);
-
-            // Begin offscreen command buffer
-            VkCommandBufferBeginInfo beginInfo{};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-            vkBeginCommandBuffer(sceneCmd, &beginInfo);
-
-            // Offscreen render pass
-            VkRenderPassBeginInfo offscreenPassInfo{};
-            offscreenPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            offscreenPassInfo.renderPass = scene->sceneRenderPass;
-            offscreenPassInfo.framebuffer = scene->sceneOffscreenFrameBuffers[*scene->imageFrameCounter];
-            offscreenPassInfo.renderArea.offset = { 0, 0 };
-            offscreenPassInfo.renderArea.extent = { scene->width, scene->height };
-
-            VkClearValue clearValues[2];
-            clearValues[0].color = { 0.0f, 0.0f, 0.4f, 1.0f };
-            clearValues[1].depthStencil = { 1.0f, 0 };
-            offscreenPassInfo.clearValueCount = 2;
-            offscreenPassInfo.pClearValues = clearValues;
-
-            vkCmdBeginRenderPass(sceneCmd, &offscreenPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-            VkViewport viewport{
-                0.0f,
-                0.0f,
-                static_cast<float>(scene->width),
-                static_cast<float>(scene->height),
-                0.0f, 1.0f };
-            vkCmdSetViewport(sceneCmd, 0, 1, &viewport);
+        offscreenCommandBuffers.clear();
 
-            VkRect2D scissor{ {0,0}, {scene->width, scene->height} };
-            vkCmdSetScissor(sceneCmd, 0, 1, &scissor);
+        // --- 4. Upload what was staged and cull every instance once, all scenes draw from the result ---
+        stagingRing.BeginFrame(vulkanCore, vulkanSurface.imageFrameCounter);
+        bool drawInstances = PrepareCulling(frameData);
+        uploadWaitValue = 0;
+        if (drawInstances || stagingRing.HasPendingCopies(vulkanSurface.imageFrameCounter) || vulkanSurface.HasPendingSceneLayerTransition(vulkanSurface.imageFrameCounter))
+            offscreenCommandBuffers.push_back(RecordTransfersAndCulling(frameData, drawInstances, uploadWaitValue));
 
-            vkCmdBindPipeline(sceneCmd, VK_PIPELINE_BIND_POINT_GRAPHICS, scene->scenePipelines[0]);
-            if (scene->SceneDescriptorResult.layout != VK_NULL_HANDLE)
-            {
-                vkCmdBindDescriptorSets(
-                    sceneCmd,
-                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                    scene->scenePipelineLayouts[0],
-                    0, 1,
-                    &scene->SceneDescriptorResult.sets[*scene->imageFrameCounter],
-                    0, nullptr
-                );
-            }
-
-            if (!scene->vertexData.empty())
-            {
-                VkBuffer vertexBuffers[] = { scene->sceneBuffers[0].buffer };
-                VkDeviceSize offsets[] = { 0 };
-                vkCmdBindVertexBuffers(sceneCmd, 0, 1, vertexBuffers, offsets);
-                vkCmdDraw(sceneCmd, static_cast<uint32_t>(scene->vertexData.size()), 1, 0, 0);
-            }
+        // --- 5. Render each scene to offscreen framebuffer ---
+        // A single scene covering the window skips its offscreen image and draws straight into the swapchain image in step 6
+        VulkanScene* directScene = DirectScene();
 
-            vkCmdEndRenderPass(sceneCmd);
-
-            vkEndCommandBuffer(sceneCmd);
-
-            // Submit offscreen command buffer
-            VkSubmitInfo sceneSubmitInfo{};
-            sceneSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-            sceneSubmitInfo.commandBufferCount = 1;
-            sceneSubmitInfo.pCommandBuffers = &sceneCmd;
-            sceneSubmitInfo.signalSemaphoreCount = 1;
-            sceneSubmitInfo.pSignalSemaphores = &scene->sceneRenderFinishedSemaphores[*scene->imageFrameCounter];
-
-            vkQueueSubmit(vulkanCore->graphicsQueue, 1, &sceneSubmitInfo, sceneFence);
-            sceneFinishedSemaphores.push_back(scene->sceneRenderFinishedSemaphores[*scene->imageFrameCounter]);
+        // Every scene records into a command buffer of its own pool, so they are recorded in parallel and joined before the submit
+        recordedScenes.clear();
+        for (auto& [sceneID, scene] : vulkanScenes)
+        {
+            if (scene && !directScene)
+                recordedScenes.push_back(scene.get());
         }
-
-        // --- 5. Record surface command buffer ---
-        VkCommandBuffer cmdBuffer = vulkanSurface.surfacePresentCommandBuffers[vulkanSurface.imageFrameCounter];
+        size_t firstSceneBuffer = offscreenCommandBuffers.size();
+        offscreenCommandBuffers.resize(firstSceneBuffer + recordedScenes.size());
+        auto recordScenes = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                offscreenCommandBuffers[firstSceneBuffer + i] = RecordScene(*recordedScenes[i], frameData, drawInstances);
+        };
+        if (parallelFor && recordedScenes.size() > 1)
+            parallelFor(recordedScenes.size(), recordScenes);
+        else
+            recordScenes(0, recordedScenes.size());
+        // The offscreen pass's external dependency makes the composite's fragment shader wait for every scene
+
+        // --- 6. Record surface command buffer ---
+        surfaceCommandBuffer = vulkanSurface.surfacePresentCommandBuffers[vulkanSurface.imageFrameCounter];
+        VkCommandBuffer cmdBuffer = surfaceCommandBuffer;
         vkResetCommandBuffer(cmdBuffer, 0);
 
         VkCommandBufferBeginInfo beginInfoSurface{};
@@ -240,17 +642,40 @@ namespace Vulkan {
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = vulkanSurface.surfaceRenderPass;
-        renderPassInfo.framebuffer = vulkanSurface.surfaceFrameBuffers[swapchainImageIndex];
+        renderPassInfo.framebuffer = vulkanSurface.surfaceFrameBuffers[acquiredImageIndex];
         renderPassInfo.renderArea.offset = { 0,0 };
         renderPassInfo.renderArea.extent = { vulkanSurface.windowSize.x, vulkanSurface.windowSize.y };
 
         VkClearValue clearValue{};
-        clearValue.color = { 0.1f, 0.2f, 0.0f, 1.0f };
+        clearValue.color = directScene ? SceneClearColor : VkClearColorValue{ { 0.1f, 0.2f, 0.0f, 1.0f } };
         renderPassInfo.clearValueCount = 1;
         renderPassInfo.pClearValues = &clearValue;
 
         vkCmdBeginRenderPass(cmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
+        if (directScene)
+        {
+            // The surface pass has the same single color attachment format as the offscreen pass, so the scene's pipeline works in it
+            VkViewport directViewport{
+                static_cast<float>(directScene->xoffset),
+                static_cast<float>(directScene->yoffset),
+                static_cast<float>(directScene->width),
+                static_cast<float>(directScene->height),
+                0.0f,
+                1.0f
+            };
+            vkCmdSetViewport(cmdBuffer, 0, 1, &directViewport);
+
+            VkRect2D directScissor{ {0,0}, {vulkanSurface.windowSize.x, vulkanSurface.windowSize.y} };
+            vkCmdSetScissor(cmdBuffer, 0, 1, &directScissor);
+
+            RecordSceneDraws(cmdBuffer, *directScene, frameData, drawInstances);
+
+            vkCmdEndRenderPass(cmdBuffer);
+            vkEndCommandBuffer(cmdBuffer);
+            return true;
+        }
+
         VkViewport viewportSurface{ 0.0f, 0.0f, static_cast<float>(vulkanSurface.windowSize.x), static_cast<float>(vulkanSurface.windowSize.y), 0.0f, 1.0f };
         vkCmdSetViewport(cmdBuffer, 0, 1, &viewportSurface);
 
@@ -283,13 +708,19 @@ namespace Vulkan {
             VkRect2D sceneScissor{ {scene->xoffset, scene->yoffset}, {scene->width, scene->height} };
             vkCmdSetScissor(cmdBuffer, 0, 1, &sceneScissor);
 
+            SurfacePushConstants pushConstants{};
+            pushConstants.uvScale = {
+                static_cast<float>(scene->width) / static_cast<float>(vulkanSurface.sceneLayerExtent.x),
+                static_cast<float>(scene->height) / static_cast<float>(vulkanSurface.sceneLayerExtent.y)
+            };
+            pushConstants.sceneLayer = static_cast<int>(scene->sceneLayer);
             vkCmdPushConstants(
                 cmdBuffer,
                 vulkanSurface.surfacePipelineLayout,
                 VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(SurfacePushConstants),
-                &scene->sceneID
+                &pushConstants
             );
 
             vkCmdDraw(cmdBuffer, 3, 1, 0, 0);
@@ -298,43 +729,53 @@ namespace Vulkan {
         vkCmdEndRenderPass(cmdBuffer);
         vkEndCommandBuffer(cmdBuffer);
 
-        // --- 6. Submit surface command buffer ---
-        std::vector<VkSemaphore> waitSemaphores;
-        std::vector<VkPipelineStageFlags> waitStages;
-
-        // Wait for swapchain image
-        waitSemaphores.push_back(vulkanSurface.surfaceImageAvailableSemaphores[vulkanSurface.imageFrameCounter]);
-        waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        return true;
+    }
 
-        // Wait for all scene offscreen passes
-        for (auto& sem : sceneFinishedSemaphores)
+    void Window::AppendSubmitInfos(std::vector<VkSubmitInfo>& submitInfos)
+    {
+        // Two batches so only the composite waits for the swapchain image, the offscreen work can start before it is acquired
+        if (!offscreenCommandBuffers.empty())
         {
-            waitSemaphores.push_back(sem);
-            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            VkSubmitInfo& offscreenSubmit = submitInfos.emplace_back();
+            offscreenSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            if (uploadWaitValue != 0)
+            {
+                uploadSemaphore = vulkanCore->uploader->GetTimelineSemaphore();
+                uploadTimelineInfo = {};
+                uploadTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+                uploadTimelineInfo.waitSemaphoreValueCount = 1;
+                uploadTimelineInfo.pWaitSemaphoreValues = &uploadWaitValue;
+
+                offscreenSubmit.pNext = &uploadTimelineInfo;
+                offscreenSubmit.waitSemaphoreCount = 1;
+                offscreenSubmit.pWaitSemaphores = &uploadSemaphore;
+                offscreenSubmit.pWaitDstStageMask = &UploadWaitStage;
+            }
+            offscreenSubmit.commandBufferCount = static_cast<uint32_t>(offscreenCommandBuffers.size());
+            offscreenSubmit.pCommandBuffers = offscreenCommandBuffers.data();
         }
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &cmdBuffer;
-        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
-        submitInfo.pWaitSemaphores = waitSemaphores.data();
-        submitInfo.pWaitDstStageMask = waitStages.data();
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &vulkanSurface.surfaceRenderFinishedSemaphores[vulkanSurface.imageFrameCounter];
-
-        vkQueueSubmit(vulkanCore->graphicsQueue, 1, &submitInfo, frameFence);
-
-        // --- 7. Present ---
-        VkPresentInfoKHR presentInfo{};
-        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = &vulkanSurface.surfaceRenderFinishedSemaphores[vulkanSurface.imageFrameCounter];
-        presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = &vulkanSurface.surfaceSwapChain;
-        presentInfo.pImageIndices = &swapchainImageIndex;
-        vkQueuePresentKHR(vulkanCore->presentQueue, &presentInfo);
+        VkSubmitInfo& surfaceSubmit = submitInfos.emplace_back();
+        surfaceSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        surfaceSubmit.waitSemaphoreCount = 1;
+        surfaceSubmit.pWaitSemaphores = &vulkanSurface.surfaceImageAvailableSemaphores[vulkanSurface.imageFrameCounter];
+        surfaceSubmit.pWaitDstStageMask = &ImageAvailableStage;
+        surfaceSubmit.commandBufferCount = 1;
+        surfaceSubmit.pCommandBuffers = &surfaceCommandBuffer;
+        surfaceSubmit.signalSemaphoreCount = 1;
+        surfaceSubmit.pSignalSemaphores = &vulkanSurface.surfaceRenderFinishedSemaphores[vulkanSurface.imageFrameCounter];
+    }
+
+    void Window::EndFrame(VkFence submitFence, VkResult presentResult)
+    {
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+            needsToBeRecreated = true;
+        else if (presentResult != VK_SUCCESS)
+            throw std::runtime_error("Failed to present swapchain image!");
 
+        vulkanSurface.inFlightFences[vulkanSurface.imageFrameCounter] = submitFence;
         vulkanSurface.imageFrameCounter = (vulkanSurface.imageFrameCounter + 1) % vulkanSurface.MAX_FRAMES_IN_FLIGHT;
+        vulkanSurface.deletionQueue.EndFrame();
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "ContextVulkanData.h"
 #include "Surface/SurfaceFlags.h"
 #include "Objects/Vertex.h"
+#include "Buffers/StagingRing.h"
 
 #include <vector>
 #include <map>
@@ -10,6 +11,7 @@
 #include <string>
 #include <random>
 #include <unordered_map>
+#include <functional>
 
 namespace Vulkan {
 	class Window {
@@ -22,6 +24,8 @@ namespace Vulkan {
 		uint8_t surfaceId;
 
 		bool needsToBeRecreated = false;
+		//Buffers that run out of room grow to at least this many times their capacity
+		float bufferGrowthFactor = 2.0f;
 
 		Window(std::shared_ptr<VulkanCore> core, SurfaceFlags flags, uint8_t id);
 
@@ -29,11 +33,31 @@ namespace Vulkan {
 		void CloseWindow();                          // Close window and unload OpenGL context
 
 
-		void SyncUniformObjectBuffer(std::unordered_map<uint32_t, Transform>& transforms);
-		void RenderScenes(std::unordered_map<uint32_t, Transform>& transforms);
+		//Copies the dirty model matrices into the current frame's mapped buffer, call once the frame's fence has been waited on
+		void SyncUniformObjectBuffer(const InstanceFrameData& frameData);
+		//Fills the current frame's group and indirect draw buffers, false when there is nothing to draw
+		bool PrepareCulling(const InstanceFrameData& frameData);
+		//Records the frame's scene layer transition and staged uploads, then with cull set the compute pass that writes the visible instances and their draw counts.
+		//uploadWaitValue is set to the AsyncUploader value the frame's submit has to wait on, 0 for none
+		VkCommandBuffer RecordTransfersAndCulling(const InstanceFrameData& frameData, bool cull, uint64_t& uploadWaitValue);
+		//Runs func over ranges of [0, count) and returns once every range is done, on whatever threads the caller has
+		using ParallelFor = std::function<void(size_t count, const std::function<void(size_t begin, size_t end)>& func)>;
+
+		//A frame in parts, FrameOrchestrator submits and presents every window's frame at once.
+		//Waits for the frame, acquires a swapchain image and records everything, false when the frame has to be skipped.
+		//Scenes are recorded through parallelFor when one is given, otherwise one after another
+		bool BeginFrame(const InstanceFrameData& frameData, const ParallelFor& parallelFor = {});
+		//Adds the begun frame's batches, they point into the window and stay valid until EndFrame
+		void AppendSubmitInfos(std::vector<VkSubmitInfo>& submitInfos);
+		//submitFence is the fence of the submit that carried the frame
+		void EndFrame(VkFence submitFence, VkResult presentResult);
+		uint32_t GetAcquiredImageIndex() const { return acquiredImageIndex; }
 
 		void resizeScenes();
 		uint8_t CreateNewScene(uint32_t width = 0, uint32_t height = 0, uint32_t posx = 0, uint32_t posy = 0);
+		void RemoveScene(uint8_t sceneID);
+		//Appends a mesh to the window's mesh vertex buffer, IDs count up from 0 in creation order
+		uint32_t CreateMesh(const std::vector<Vertex>& vertices);
 		inline uint32_t GetNextSceneID() {
 			return nextSceneID++;
 		}
@@ -43,5 +67,52 @@ namespace Vulkan {
 		Window& operator=(const Window&) = delete;
 	private:
 		uint8_t nextSceneID = 1;
+
+		//Every mesh's vertices back to back, shared by all scenes of the window
+		std::vector<Vertex> meshVertices{};
+		std::vector<MeshRange> meshes{};
+		//Parallel to meshes, timeline value of the AsyncUploader the mesh's vertices land at, 0 when they went through the stagingRing
+		std::vector<uint64_t> meshUploadValues{};
+		//Highest upload value a frame has already made the graphics queue wait for
+		uint64_t waitedUploadValue = 0;
+		//Parallel to meshes, local bounding sphere as xyz center and w radius
+		std::vector<glm::vec4> meshBounds{};
+		VulkanBuffer meshVertexBuffer{};
+		//Uploads to device local buffers, copied at the start of the next rendered frame
+		StagingRing stagingRing{};
+
+		void RecordCulling(VkCommandBuffer cullCmd, const InstanceFrameData& frameData);
+		//Only touches the scene's own command pool and reads shared state, so scenes can be recorded on different threads
+		VkCommandBuffer RecordScene(VulkanScene& scene, const InstanceFrameData& frameData, bool drawInstances);
+		//Binds the scene's pipeline and draws the instances into whatever pass cmd is in
+		void RecordSceneDraws(VkCommandBuffer cmd, VulkanScene& scene, const InstanceFrameData& frameData, bool drawInstances);
+		//The only scene when it covers the whole window, null when the frame has to composite
+		VulkanScene* DirectScene() const;
+		static constexpr VkClearColorValue SceneClearColor{ { 0.0f, 0.0f, 0.4f, 1.0f } };
+		//Scratch for BeginFrame, the scenes recorded this frame in order
+		std::vector<VulkanScene*> recordedScenes{};
+
+		//The frame between BeginFrame and EndFrame
+		uint32_t acquiredImageIndex = 0;
+		//Everything up to the composite, submitted as one batch ahead of it. Barriers order the batch
+		std::vector<VkCommandBuffer> offscreenCommandBuffers{};
+		VkCommandBuffer surfaceCommandBuffer = VK_NULL_HANDLE;
+		uint64_t uploadWaitValue = 0;
+		VkSemaphore uploadSemaphore = VK_NULL_HANDLE;
+		VkTimelineSemaphoreSubmitInfo uploadTimelineInfo{};
+		static constexpr VkPipelineStageFlags UploadWaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		static constexpr VkPipelineStageFlags ImageAvailableStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		void UploadMeshBounds();
+		//Stages data for dst through the current frame's staging memory, without waiting on the queue
+		void StageUpload(const VulkanBuffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		//Waits on the current frame's fence, which has almost always signalled, and frees its staging space
+		uint32_t BeginStagingFrame();
+		VkDeviceSize GrownCapacity(VkDeviceSize capacity, VkDeviceSize requiredSize) const;
+
+		//Points binding at buffer in frame's instance descriptor set, for buffers replaced while growing
+		void WriteInstanceDescriptor(uint32_t frame, uint32_t binding, const VulkanBuffer& buffer);
+		//Past this many pending ranges a frame just copies one range spanning all of them
+		static constexpr size_t MaxPendingModelMatrixRanges = 64;
 	};
 }
\ No newline at end of file
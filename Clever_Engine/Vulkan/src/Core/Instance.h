@@ -53,7 +53,7 @@ namespace Vulkan
 		appInfo.pApplicationName = "Clever_Engine";
 		appInfo.applicationVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
 		appInfo.pEngineName = "Clever";
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_2;//1.2 for timeline semaphores
 
 		auto extensions = getRequiredExtensions();
 
@@ -7,7 +7,7 @@
 
 namespace Vulkan {
 
-	PhysicalDeviceData GetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice)
+	PhysicalDeviceData GetPhysicalDeviceProperties(VkInstance instance, VkPhysicalDevice physicalDevice)
 	{
 		uint32_t queueFamilyPropertyCount = 0;
 		std::vector<VkQueueFamilyProperties> queueFamilyPropteries;
@@ -25,22 +25,50 @@ namespace Vulkan {
 		PhysicalDeviceData physicalDeviceData;
 
 		physicalDeviceData.deviceName = physicalDeviceProperties.deviceName;
+		physicalDeviceData.supportsTimelineSemaphores = physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2;
 
-		int i = 0;
-		for (const auto& queueFamilyProperty : queueFamilyPropteries)
+		std::optional<uint32_t> transferOnlyIndex;
+		std::optional<uint32_t> asyncComputeIndex;
+		for (uint32_t i = 0; i < queueFamilyPropertyCount; i++)
 		{
-			if (queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			const VkQueueFamilyProperties& queueFamilyProperty = queueFamilyPropteries[i];
+			bool present = glfwGetPhysicalDevicePresentationSupport(instance, physicalDevice, i) == GLFW_TRUE;
+
+			if (!physicalDeviceData.graphicsIndex.has_value() && (queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT))
 			{
 				physicalDeviceData.graphicsIndex = i;
+				//Presenting from the graphics family saves the swapchain from being shared
+				if (present)
+					physicalDeviceData.presentIndex = i;
 			}
-			if (queueFamilyProperty.queueFlags & VK_QUEUE_TRANSFER_BIT)
+			if (!physicalDeviceData.presentIndex.has_value() && present)
 			{
 				physicalDeviceData.presentIndex = i;
 			}
-			if (physicalDeviceData.graphicsIndex.has_value() && physicalDeviceData.presentIndex.has_value())
-				break;
 
-			i++;
+			//Graphics and compute families can always transfer, even if they do not say so
+			if (!(queueFamilyProperty.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				if (!(queueFamilyProperty.queueFlags & VK_QUEUE_COMPUTE_BIT) && (queueFamilyProperty.queueFlags & VK_QUEUE_TRANSFER_BIT))
+				{
+					if (!transferOnlyIndex.has_value())
+						transferOnlyIndex = i;
+				}
+				else if ((queueFamilyProperty.queueFlags & VK_QUEUE_COMPUTE_BIT) && !asyncComputeIndex.has_value())
+				{
+					asyncComputeIndex = i;
+				}
+			}
+		}
+
+		//A dedicated transfer family is the copy engine, otherwise async compute still runs next to graphics
+		physicalDeviceData.transferIndex = transferOnlyIndex.has_value() ? transferOnlyIndex : asyncComputeIndex;
+		if (!physicalDeviceData.transferIndex.has_value() && physicalDeviceData.graphicsIndex.has_value() &&
+			queueFamilyPropteries[physicalDeviceData.graphicsIndex.value()].queueCount > 1)
+		{
+			//Second queue of the graphics family
+			physicalDeviceData.transferIndex = physicalDeviceData.graphicsIndex;
+			physicalDeviceData.transferQueueIndex = 1;
 		}
 		return physicalDeviceData;
 	};
@@ -63,17 +91,28 @@ namespace Vulkan {
 		bool graphicsQueue = false;
 		bool presentQueue = false;
 
-		PhysicalDeviceData QFI = GetPhysicalDeviceProperties(vulkanCore.vkPhysicalDevice);
+		PhysicalDeviceData QFI = GetPhysicalDeviceProperties(vulkanCore.vkInstance, vulkanCore.vkPhysicalDevice);
 
-		float queuePriority = 1.0f;
+		//Uploads need timeline semaphores, without them everything stays on the graphics queue
+		bool useTransferQueue = QFI.transferIndex.has_value() && QFI.supportsTimelineSemaphores;
+		if (!useTransferQueue)
+		{
+			vulkanCore.d_PhysicalDeviceData.transferIndex.reset();
+		}
+
+		//Uploads are less urgent than the frame
+		float queuePriorities[] = { 1.0f, 0.5f };
 		std::set<uint32_t> uniqueIndicies = { QFI.graphicsIndex.value(), QFI.presentIndex.value() };
+		if (useTransferQueue)
+			uniqueIndicies.insert(QFI.transferIndex.value());
 		for (auto index : uniqueIndicies)
 		{
 			VkDeviceQueueCreateInfo info{};
 			info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			info.queueFamilyIndex = index;
-			info.queueCount = 1;
-			info.pQueuePriorities = &queuePriority;
+			info.queueCount = (useTransferQueue && index == QFI.transferIndex.value()) ? QFI.transferQueueIndex + 1 : 1;
+			bool transferOnly = useTransferQueue && index == QFI.transferIndex.value() && index != QFI.graphicsIndex.value();
+			info.pQueuePriorities = transferOnly ? &queuePriorities[1] : queuePriorities;
 			queueCreateInfo.push_back(info);
 		}
 
@@ -81,6 +120,9 @@ namespace Vulkan {
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.fillModeNonSolid = true;
 		deviceFeatures.wideLines = true;
+		//GPU culling writes one indirect draw per mesh group, each starting at its group's first instance
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
 
 		std::vector<const char*> deviceExtextions =
 		{
@@ -92,8 +134,13 @@ namespace Vulkan {
 			"VK_LAYER_KHRONOS_validation"
 		};
 
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.pNext = useTransferQueue ? &vulkan12Features : nullptr;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfo.size());
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfo.data();
 		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
@@ -109,5 +156,9 @@ namespace Vulkan {
 
 		vkGetDeviceQueue(vulkanCore.vkDevice, vulkanCore.d_PhysicalDeviceData.graphicsIndex.value(), 0, &vulkanCore.graphicsQueue);
 		vkGetDeviceQueue(vulkanCore.vkDevice, vulkanCore.d_PhysicalDeviceData.presentIndex.value(), 0, &vulkanCore.presentQueue);
+		if (useTransferQueue)
+		{
+			vkGetDeviceQueue(vulkanCore.vkDevice, QFI.transferIndex.value(), QFI.transferQueueIndex, &vulkanCore.transferQueue);
+		}
 	}
 }
\ No newline at end of file
@@ -24,7 +24,7 @@ namespace Vulkan {
 
 		for (VkPhysicalDevice physicalDevice : possiblePhysicalDevices)
 		{
-			PhysicalDeviceData physicalDeviceData = GetPhysicalDeviceProperties(physicalDevice);
+			PhysicalDeviceData physicalDeviceData = GetPhysicalDeviceProperties(vulkanCore.vkInstance, physicalDevice);
 
 			if (physicalDeviceData.isComplete())
 			{
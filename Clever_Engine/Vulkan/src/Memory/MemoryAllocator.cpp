@@ -0,0 +1,442 @@
+#include "MemoryAllocator.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Vulkan {
+
+	namespace {
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		}
+
+		VkDeviceSize NextPowerOfTwo(VkDeviceSize value)
+		{
+			VkDeviceSize power = 1;
+			while (power < value)
+				power <<= 1;
+			return power;
+		}
+	}
+
+	//---------------- Buddy ----------------
+
+	BuddySubAllocator::BuddySubAllocator(VkDeviceSize pageSize, VkDeviceSize minBlockSize)
+		: pageSize(pageSize), minBlockSize(minBlockSize)
+	{
+		maxOrder = OrderOf(pageSize);
+		freeBlocks.resize(static_cast<size_t>(maxOrder) + 1);
+		Reset();
+	}
+
+	uint32_t BuddySubAllocator::OrderOf(VkDeviceSize blockSize) const
+	{
+		uint32_t order = 0;
+		while (BlockSize(order) < blockSize)
+			++order;
+		return order;
+	}
+
+	bool BuddySubAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved)
+	{
+		//Blocks are aligned to their own size, so a block at least as big as the alignment is always aligned
+		VkDeviceSize blockSize = std::max({ NextPowerOfTwo(size), NextPowerOfTwo(alignment), minBlockSize });
+		if (blockSize > pageSize)
+			return false;
+
+		uint32_t order = OrderOf(blockSize);
+		uint32_t found = order;
+		while (found <= maxOrder && freeBlocks[found].empty())
+			++found;
+		if (found > maxOrder)
+			return false;
+
+		//Lowest offset first keeps the page packed towards the start
+		VkDeviceSize offset = *freeBlocks[found].begin();
+		freeBlocks[found].erase(freeBlocks[found].begin());
+
+		//Split down to the wanted order, the upper halves become free buddies
+		while (found > order)
+		{
+			--found;
+			freeBlocks[found].insert(offset + BlockSize(found));
+		}
+
+		usedBytes += blockSize;
+		outOffset = offset;
+		outReserved = blockSize;
+		return true;
+	}
+
+	void BuddySubAllocator::Free(VkDeviceSize offset, VkDeviceSize reserved)
+	{
+		usedBytes -= reserved;
+
+		uint32_t order = OrderOf(reserved);
+		while (order < maxOrder)
+		{
+			VkDeviceSize buddy = offset ^ BlockSize(order);
+			auto it = freeBlocks[order].find(buddy);
+			if (it == freeBlocks[order].end())
+				break;
+
+			freeBlocks[order].erase(it);
+			offset = std::min(offset, buddy);
+			++order;
+		}
+		freeBlocks[order].insert(offset);
+	}
+
+	void BuddySubAllocator::Reset()
+	{
+		for (std::set<VkDeviceSize>& blocks : freeBlocks)
+			blocks.clear();
+		freeBlocks[maxOrder].insert(0);
+		usedBytes = 0;
+	}
+
+	VkDeviceSize BuddySubAllocator::LargestFreeBlock() const
+	{
+		for (uint32_t order = maxOrder + 1; order-- > 0;)
+		{
+			if (!freeBlocks[order].empty())
+				return BlockSize(order);
+		}
+		return 0;
+	}
+
+	uint32_t BuddySubAllocator::FreeBlockCount() const
+	{
+		size_t count = 0;
+		for (const std::set<VkDeviceSize>& blocks : freeBlocks)
+			count += blocks.size();
+		return static_cast<uint32_t>(count);
+	}
+
+	//---------------- Linear ----------------
+
+	bool LinearSubAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved)
+	{
+		VkDeviceSize offset = AlignUp(head, alignment);
+		if (offset + size > pageSize)
+			return false;
+
+		//Padding in front counts as part of the allocation, so UsedBytes stays head
+		outOffset = offset;
+		outReserved = offset + size - head;
+		head = offset + size;
+		++liveAllocations;
+		return true;
+	}
+
+	void LinearSubAllocator::Free(VkDeviceSize, VkDeviceSize)
+	{
+		if (--liveAllocations == 0)
+			head = 0;
+	}
+
+	//---------------- Pool ----------------
+
+	PoolSubAllocator::PoolSubAllocator(VkDeviceSize pageSize, VkDeviceSize blockSize)
+		: blockSize(blockSize), blockCount(pageSize / blockSize)
+	{
+		Reset();
+	}
+
+	bool PoolSubAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved)
+	{
+		if (size > blockSize || blockSize % std::max<VkDeviceSize>(alignment, 1) != 0 || freeList.empty())
+			return false;
+
+		outOffset = static_cast<VkDeviceSize>(freeList.back()) * blockSize;
+		outReserved = blockSize;
+		freeList.pop_back();
+		return true;
+	}
+
+	void PoolSubAllocator::Free(VkDeviceSize offset, VkDeviceSize)
+	{
+		freeList.push_back(static_cast<uint32_t>(offset / blockSize));
+	}
+
+	void PoolSubAllocator::Reset()
+	{
+		//Reversed so blocks are handed out from the start of the page
+		freeList.resize(blockCount);
+		for (uint32_t i = 0; i < blockCount; ++i)
+			freeList[i] = static_cast<uint32_t>(blockCount - 1 - i);
+	}
+
+	//---------------- MemoryPool ----------------
+
+	MemoryPool::MemoryPool(VkDevice device, uint32_t memoryType, bool hostVisible, AllocationStrategy strategy, VkDeviceSize pageSize, VkDeviceSize blockSize)
+		: device(device), memoryType(memoryType), hostVisible(hostVisible), strategy(strategy), pageSize(pageSize), blockSize(blockSize)
+	{
+		if (strategy == AllocationStrategy::Buddy)
+			this->pageSize = NextPowerOfTwo(pageSize);
+		if (strategy == AllocationStrategy::Pool && (blockSize == 0 || blockSize > pageSize))
+			throw std::runtime_error("Pool strategy needs a block size that fits in a page!");
+	}
+
+	MemoryPool::~MemoryPool()
+	{
+		for (Page& page : pages)
+			DestroyPage(page);
+	}
+
+	MemoryAllocation MemoryPool::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		MemoryAllocation allocation{};
+		for (uint32_t i = 0; i < pages.size(); ++i)
+		{
+			if (pages[i].memory != VK_NULL_HANDLE && TryAllocate(i, size, alignment, allocation))
+				return allocation;
+		}
+
+		if (!TryAllocate(CreatePage(), size, alignment, allocation))
+			throw std::runtime_error("Allocation does not fit in a memory pool page!");
+		return allocation;
+	}
+
+	bool MemoryPool::TryAllocate(uint32_t pageIndex, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& outAllocation)
+	{
+		Page& page = pages[pageIndex];
+		VkDeviceSize offset = 0;
+		VkDeviceSize reserved = 0;
+		if (!page.allocator->Allocate(size, alignment, offset, reserved))
+			return false;
+
+		++page.allocationCount;
+		outAllocation.memory = page.memory;
+		outAllocation.offset = offset;
+		outAllocation.size = reserved;
+		outAllocation.mapped = page.mapped ? static_cast<char*>(page.mapped) + offset : nullptr;
+		outAllocation.pool = this;
+		outAllocation.page = pageIndex;
+		return true;
+	}
+
+	void MemoryPool::Free(const MemoryAllocation& allocation)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Page& page = pages[allocation.page];
+		page.allocator->Free(allocation.offset, allocation.size);
+		--page.allocationCount;
+
+		//Keep one empty page around so a buffer that gets freed and recreated every frame does not hit vkAllocateMemory each time
+		if (page.allocationCount == 0)
+		{
+			for (Page& other : pages)
+			{
+				if (&other != &page && other.memory != VK_NULL_HANDLE && other.allocationCount == 0)
+				{
+					DestroyPage(page);
+					break;
+				}
+			}
+		}
+	}
+
+	void MemoryPool::Reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (Page& page : pages)
+		{
+			if (page.memory == VK_NULL_HANDLE)
+				continue;
+			page.allocator->Reset();
+			page.allocationCount = 0;
+		}
+	}
+
+	uint32_t MemoryPool::CreatePage()
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = pageSize;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		Page page{};
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &page.memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate memory pool page!");
+		if (hostVisible)
+			vkMapMemory(device, page.memory, 0, VK_WHOLE_SIZE, 0, &page.mapped);
+
+		switch (strategy)
+		{
+		case AllocationStrategy::Buddy:  page.allocator = std::make_unique<BuddySubAllocator>(pageSize); break;
+		case AllocationStrategy::Linear: page.allocator = std::make_unique<LinearSubAllocator>(pageSize); break;
+		case AllocationStrategy::Pool:   page.allocator = std::make_unique<PoolSubAllocator>(pageSize, blockSize); break;
+		}
+
+		//Reuse a released slot so the vector does not keep growing
+		for (uint32_t i = 0; i < pages.size(); ++i)
+		{
+			if (pages[i].memory == VK_NULL_HANDLE)
+			{
+				pages[i] = std::move(page);
+				return i;
+			}
+		}
+		pages.push_back(std::move(page));
+		return static_cast<uint32_t>(pages.size()) - 1;
+	}
+
+	void MemoryPool::DestroyPage(Page& page)
+	{
+		if (page.memory == VK_NULL_HANDLE)
+			return;
+		if (page.mapped)
+			vkUnmapMemory(device, page.memory);
+		vkFreeMemory(device, page.memory, nullptr);
+		page = Page{};
+	}
+
+	void MemoryPool::AddStats(MemoryStats& stats)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const Page& page : pages)
+		{
+			if (page.memory == VK_NULL_HANDLE)
+				continue;
+			++stats.pageCount;
+			stats.allocationCount += page.allocationCount;
+			stats.reservedBytes += pageSize;
+			stats.usedBytes += page.allocator->UsedBytes();
+			stats.largestFreeBlock = std::max(stats.largestFreeBlock, page.allocator->LargestFreeBlock());
+			stats.freeBlockCount += page.allocator->FreeBlockCount();
+		}
+	}
+
+	//---------------- MemoryAllocator ----------------
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize pageSize)
+		: device(device), pageSize(pageSize)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		bufferPools.resize(memoryProperties.memoryTypeCount);
+		imagePools.resize(memoryProperties.memoryTypeCount);
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		//Pools free their pages themselves, dedicated allocations are expected to be freed by their owners
+		bufferPools.clear();
+		imagePools.clear();
+		customPools.clear();
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+				return i;
+			}
+		}
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	bool MemoryAllocator::IsHostVisible(uint32_t memoryType) const
+	{
+		return (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+	MemoryPool& MemoryAllocator::GetDefaultPool(uint32_t memoryType, ResourceKind kind)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unique_ptr<MemoryPool>& pool = kind == ResourceKind::Buffer ? bufferPools[memoryType] : imagePools[memoryType];
+		if (!pool)
+		{
+			bool hostVisible = IsHostVisible(memoryType);
+			pool = std::make_unique<MemoryPool>(device, memoryType, hostVisible, AllocationStrategy::Buddy, hostVisible ? pageSize / 4 : pageSize);
+		}
+		return *pool;
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind)
+	{
+		uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+		bool hostVisible = IsHostVisible(memoryType);
+		VkDeviceSize typePageSize = hostVisible ? pageSize / 4 : pageSize;
+
+		if (requirements.size <= typePageSize / 2)
+			return GetDefaultPool(memoryType, kind).Allocate(requirements.size, requirements.alignment);
+
+		//Dedicated, a page would be mostly this one allocation anyway
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		MemoryAllocation allocation{};
+		if (vkAllocateMemory(device, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate dedicated memory!");
+		if (hostVisible)
+			vkMapMemory(device, allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped);
+		allocation.size = requirements.size;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		++dedicatedAllocationCount;
+		dedicatedBytes += requirements.size;
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(MemoryAllocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+			return;
+
+		if (allocation.pool)
+		{
+			allocation.pool->Free(allocation);
+		}
+		else
+		{
+			if (allocation.mapped)
+				vkUnmapMemory(device, allocation.memory);
+			vkFreeMemory(device, allocation.memory, nullptr);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			--dedicatedAllocationCount;
+			dedicatedBytes -= allocation.size;
+		}
+		allocation = MemoryAllocation{};
+	}
+
+	MemoryPool* MemoryAllocator::CreatePool(uint32_t memoryType, AllocationStrategy strategy, VkDeviceSize poolPageSize, VkDeviceSize blockSize)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		customPools.push_back(std::make_unique<MemoryPool>(device, memoryType, IsHostVisible(memoryType), strategy, poolPageSize, blockSize));
+		return customPools.back().get();
+	}
+
+	void MemoryAllocator::DestroyPool(MemoryPool* pool)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		customPools.erase(std::remove_if(customPools.begin(), customPools.end(),
+			[pool](const std::unique_ptr<MemoryPool>& p) { return p.get() == pool; }), customPools.end());
+	}
+
+	MemoryStats MemoryAllocator::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		MemoryStats stats{};
+		for (auto* pools : { &bufferPools, &imagePools, &customPools })
+		{
+			for (std::unique_ptr<MemoryPool>& pool : *pools)
+			{
+				if (pool)
+					pool->AddStats(stats);
+			}
+		}
+		stats.dedicatedAllocationCount = dedicatedAllocationCount;
+		stats.allocationCount += dedicatedAllocationCount;
+		stats.reservedBytes += dedicatedBytes;
+		stats.usedBytes += dedicatedBytes;
+		return stats;
+	}
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <memory>
+
+#include "Context/ContextVulkanData.h"
+
+namespace Vulkan {
+
+	enum class AllocationStrategy : uint8_t {
+		Buddy,  // General purpose, power of two blocks that merge back with their buddy when freed
+		Linear, // Bump allocator, memory only comes back once every allocation of a page is freed or the pool is Reset
+		Pool    // Fixed size blocks, for many allocations of the same size
+	};
+
+	//Memory statistics, summed over whatever they were collected from
+	struct MemoryStats
+	{
+		uint32_t pageCount = 0;
+		uint32_t dedicatedAllocationCount = 0; // Too big for a page, got their own VkDeviceMemory
+		uint32_t allocationCount = 0;
+		VkDeviceSize reservedBytes = 0;        // Every VkDeviceMemory allocated
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize largestFreeBlock = 0;
+		uint32_t freeBlockCount = 0;
+
+		//0 when the free space of every page is one block, towards 1 as it splinters
+		float Fragmentation() const
+		{
+			VkDeviceSize freeBytes = reservedBytes - usedBytes;
+			if (freeBytes == 0 || freeBlockCount <= 1)
+				return 0.0f;
+			return 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeBytes);
+		}
+	};
+
+	/*
+	Hands out ranges of a single page, offsets are relative to the page.
+	reserved is what the range actually takes up, it is what has to be passed back to Free.
+	*/
+	class SubAllocator
+	{
+	public:
+		virtual ~SubAllocator() = default;
+
+		//False when the page has no room left
+		virtual bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved) = 0;
+		virtual void Free(VkDeviceSize offset, VkDeviceSize reserved) = 0;
+		//Forgets every allocation at once
+		virtual void Reset() = 0;
+
+		virtual VkDeviceSize UsedBytes() const = 0;
+		virtual VkDeviceSize LargestFreeBlock() const = 0;
+		virtual uint32_t FreeBlockCount() const = 0;
+	};
+
+	class BuddySubAllocator : public SubAllocator
+	{
+	public:
+		//pageSize and minBlockSize must be powers of two
+		BuddySubAllocator(VkDeviceSize pageSize, VkDeviceSize minBlockSize = 256);
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved) override;
+		void Free(VkDeviceSize offset, VkDeviceSize reserved) override;
+		void Reset() override;
+
+		VkDeviceSize UsedBytes() const override { return usedBytes; }
+		VkDeviceSize LargestFreeBlock() const override;
+		uint32_t FreeBlockCount() const override;
+	private:
+		uint32_t OrderOf(VkDeviceSize blockSize) const;
+		VkDeviceSize BlockSize(uint32_t order) const { return minBlockSize << order; }
+	private:
+		VkDeviceSize pageSize;
+		VkDeviceSize minBlockSize;
+		uint32_t maxOrder;
+		//Offsets of the free blocks of each order, order n blocks are minBlockSize << n bytes
+		std::vector<std::set<VkDeviceSize>> freeBlocks;
+		VkDeviceSize usedBytes = 0;
+	};
+
+	class LinearSubAllocator : public SubAllocator
+	{
+	public:
+		LinearSubAllocator(VkDeviceSize pageSize) : pageSize(pageSize) {}
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved) override;
+		void Free(VkDeviceSize offset, VkDeviceSize reserved) override;
+		void Reset() override { head = 0; liveAllocations = 0; }
+
+		VkDeviceSize UsedBytes() const override { return head; }
+		VkDeviceSize LargestFreeBlock() const override { return pageSize - head; }
+		uint32_t FreeBlockCount() const override { return head < pageSize ? 1 : 0; }
+	private:
+		VkDeviceSize pageSize;
+		VkDeviceSize head = 0;
+		uint32_t liveAllocations = 0;
+	};
+
+	class PoolSubAllocator : public SubAllocator
+	{
+	public:
+		PoolSubAllocator(VkDeviceSize pageSize, VkDeviceSize blockSize);
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, VkDeviceSize& outReserved) override;
+		void Free(VkDeviceSize offset, VkDeviceSize reserved) override;
+		void Reset() override;
+
+		VkDeviceSize UsedBytes() const override { return (blockCount - freeList.size()) * blockSize; }
+		VkDeviceSize LargestFreeBlock() const override { return freeList.empty() ? 0 : blockSize; }
+		uint32_t FreeBlockCount() const override { return static_cast<uint32_t>(freeList.size()); }
+	private:
+		VkDeviceSize blockSize;
+		VkDeviceSize blockCount;
+		std::vector<uint32_t> freeList;
+	};
+
+	/*
+	Pages of one memory type, all carved up with the same strategy. Host visible pages are mapped once when created,
+	so every allocation out of them comes with a pointer. Thread safe.
+	*/
+	class MemoryPool
+	{
+	public:
+		MemoryPool(VkDevice device, uint32_t memoryType, bool hostVisible, AllocationStrategy strategy, VkDeviceSize pageSize, VkDeviceSize blockSize = 0);
+		~MemoryPool();
+
+		//Throws if size can never fit in a page of this pool
+		MemoryAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+		void Free(const MemoryAllocation& allocation);
+		//Releases every allocation at once, the caller makes sure the GPU is done with all of them
+		void Reset();
+
+		void AddStats(MemoryStats& stats);
+		uint32_t GetMemoryType() const { return memoryType; }
+
+		MemoryPool(const MemoryPool&) = delete;
+		MemoryPool& operator=(const MemoryPool&) = delete;
+	private:
+		struct Page
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;
+			std::unique_ptr<SubAllocator> allocator;
+			uint32_t allocationCount = 0;
+		};
+
+		bool TryAllocate(uint32_t pageIndex, VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation& outAllocation);
+		//Returns the index of the new page
+		uint32_t CreatePage();
+		void DestroyPage(Page& page);
+	private:
+		VkDevice device;
+		uint32_t memoryType;
+		bool hostVisible;
+		AllocationStrategy strategy;
+		VkDeviceSize pageSize;
+		VkDeviceSize blockSize;
+
+		//Freed pages stay in the vector with a null memory handle so page indices in live allocations stay valid
+		std::vector<Page> pages;
+		std::mutex mutex;
+	};
+
+	/*
+	Owns every device memory allocation of a VulkanCore, so buffers and images no longer call vkAllocateMemory each.
+	Allocations come out of Buddy pools per memory type, with buffers and images in separate pages so bufferImageGranularity never matters.
+	Anything bigger than half a page gets a dedicated VkDeviceMemory. Linear and Pool strategies are available through CreatePool.
+	*/
+	class MemoryAllocator
+	{
+	public:
+		enum class ResourceKind : uint8_t { Buffer, Image };
+
+		//Host visible pages are a quarter of pageSize, those heaps tend to be small
+		MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize pageSize = 64ull * 1024 * 1024);
+		~MemoryAllocator();
+
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind);
+		//Works for allocations out of CreatePool pools too, resets allocation
+		void Free(MemoryAllocation& allocation);
+
+		//A pool with its own strategy and page size, blockSize is only used by AllocationStrategy::Pool. Freed along with the allocator
+		MemoryPool* CreatePool(uint32_t memoryType, AllocationStrategy strategy, VkDeviceSize pageSize, VkDeviceSize blockSize = 0);
+		void DestroyPool(MemoryPool* pool);
+
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		bool IsHostVisible(uint32_t memoryType) const;
+
+		MemoryStats GetStats();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+	private:
+		MemoryPool& GetDefaultPool(uint32_t memoryType, ResourceKind kind);
+	private:
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		VkDeviceSize pageSize;
+
+		//Indexed by memory type, created on first use
+		std::vector<std::unique_ptr<MemoryPool>> bufferPools;
+		std::vector<std::unique_ptr<MemoryPool>> imagePools;
+		std::vector<std::unique_ptr<MemoryPool>> customPools;
+
+		uint32_t dedicatedAllocationCount = 0;
+		VkDeviceSize dedicatedBytes = 0;
+		std::mutex mutex;
+	};
+}
@@ -51,6 +51,4 @@ struct Transform
 		// Combine transformations: ModelMatrix = Translation * Rotation * Scale
 		modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
 	}
-
-	bool isDirty = true;
 };
\ No newline at end of file
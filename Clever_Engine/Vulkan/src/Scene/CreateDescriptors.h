@@ -5,81 +5,86 @@
 #include "Context/ContextVulkanData.h"
 
 namespace Vulkan {
-    inline void UpdateDescriptorSets(std::shared_ptr<VulkanCore> VC, const DescriptorSetInfo& info, DescriptorResult& result)
+    // Writes one frame's set, frame is also which of the framesInFlight interleaved entries of each binding is used
+    inline void UpdateDescriptorSet(std::shared_ptr<VulkanCore> VC, const DescriptorSetInfo& info, DescriptorResult& result, uint32_t frame)
     {
         VkDevice device = VC->vkDevice;
         const uint32_t framesInFlight = info.maxSets;
 
-        for (uint32_t frame = 0; frame < framesInFlight; ++frame) {
-            std::vector<VkWriteDescriptorSet> writes;
-            std::vector<std::vector<VkDescriptorImageInfo>> imageStorage;
-            std::vector<std::vector<VkDescriptorBufferInfo>> bufferStorage;
+        std::vector<VkWriteDescriptorSet> writes;
+        std::vector<std::vector<VkDescriptorImageInfo>> imageStorage;
+        std::vector<std::vector<VkDescriptorBufferInfo>> bufferStorage;
 
-            imageStorage.reserve(info.bindings.size());
-            bufferStorage.reserve(info.bindings.size());
+        imageStorage.reserve(info.bindings.size());
+        bufferStorage.reserve(info.bindings.size());
 
-            for (const auto& b : info.bindings) {
-                uint32_t perSetCount = 0;
-
-                if (!b.images.empty()) {
-                    perSetCount = static_cast<uint32_t>(b.images.size() / framesInFlight);
-                    imageStorage.emplace_back(perSetCount);
-
-                    for (uint32_t scene = 0; scene < perSetCount; ++scene) {
-                        uint32_t idx = scene * framesInFlight + frame;
-                        imageStorage.back()[scene] = b.images[idx];
-                    }
-
-                    VkWriteDescriptorSet write{};
-                    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    write.dstSet = result.sets[frame];
-                    write.dstBinding = b.binding;
-                    write.dstArrayElement = 0;
-                    write.descriptorType = b.type;
-                    write.descriptorCount = perSetCount;
-                    write.pImageInfo = imageStorage.back().data();
-                    writes.push_back(write);
-                }
-                else if (!b.buffers.empty()) {
-                    perSetCount = static_cast<uint32_t>(b.buffers.size() / framesInFlight);
-                    bufferStorage.emplace_back(perSetCount);
-
-                    for (uint32_t scene = 0; scene < perSetCount; ++scene) {
-                        uint32_t idx = scene * framesInFlight + frame;
-                        bufferStorage.back()[scene] = b.buffers[idx];
-                    }
-
-                    VkWriteDescriptorSet write{};
-                    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    write.dstSet = result.sets[frame];
-                    write.dstBinding = b.binding;
-                    write.dstArrayElement = 0;
-                    write.descriptorType = b.type;
-                    write.descriptorCount = perSetCount;
-                    write.pBufferInfo = bufferStorage.back().data();
-                    writes.push_back(write);
-                }
-                else {
-                    perSetCount = b.count;
-                    if (perSetCount == 0) continue;
-
-                    VkWriteDescriptorSet write{};
-                    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    write.dstSet = result.sets[frame];
-                    write.dstBinding = b.binding;
-                    write.dstArrayElement = 0;
-                    write.descriptorType = b.type;
-                    write.descriptorCount = perSetCount;
-                    write.pBufferInfo = nullptr;
-                    write.pImageInfo = nullptr;
-                    writes.push_back(write);
+        for (const auto& b : info.bindings) {
+            uint32_t perSetCount = 0;
+
+            if (!b.images.empty()) {
+                perSetCount = static_cast<uint32_t>(b.images.size() / framesInFlight);
+                imageStorage.emplace_back(perSetCount);
+
+                for (uint32_t scene = 0; scene < perSetCount; ++scene) {
+                    uint32_t idx = scene * framesInFlight + frame;
+                    imageStorage.back()[scene] = b.images[idx];
                 }
+
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = result.sets[frame];
+                write.dstBinding = b.binding;
+                write.dstArrayElement = 0;
+                write.descriptorType = b.type;
+                write.descriptorCount = perSetCount;
+                write.pImageInfo = imageStorage.back().data();
+                writes.push_back(write);
             }
+            else if (!b.buffers.empty()) {
+                perSetCount = static_cast<uint32_t>(b.buffers.size() / framesInFlight);
+                bufferStorage.emplace_back(perSetCount);
 
-            if (!writes.empty()) {
-                vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+                for (uint32_t scene = 0; scene < perSetCount; ++scene) {
+                    uint32_t idx = scene * framesInFlight + frame;
+                    bufferStorage.back()[scene] = b.buffers[idx];
+                }
+
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = result.sets[frame];
+                write.dstBinding = b.binding;
+                write.dstArrayElement = 0;
+                write.descriptorType = b.type;
+                write.descriptorCount = perSetCount;
+                write.pBufferInfo = bufferStorage.back().data();
+                writes.push_back(write);
+            }
+            else {
+                perSetCount = b.count;
+                if (perSetCount == 0) continue;
+
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = result.sets[frame];
+                write.dstBinding = b.binding;
+                write.dstArrayElement = 0;
+                write.descriptorType = b.type;
+                write.descriptorCount = perSetCount;
+                write.pBufferInfo = nullptr;
+                write.pImageInfo = nullptr;
+                writes.push_back(write);
             }
         }
+
+        if (!writes.empty()) {
+            vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    inline void UpdateDescriptorSets(std::shared_ptr<VulkanCore> VC, const DescriptorSetInfo& info, DescriptorResult& result)
+    {
+        for (uint32_t frame = 0; frame < info.maxSets; ++frame)
+            UpdateDescriptorSet(VC, info, result, frame);
     }
 
     inline DescriptorResult CreateDescriptors(std::shared_ptr<VulkanCore> VC, const DescriptorSetInfo& info)
@@ -153,4 +153,30 @@ namespace Vulkan
 
         return pipeline;
     }
+
+    inline VkPipeline CreateComputePipeline(std::shared_ptr<VulkanCore> VC, const std::string& compShaderPath, VkPipelineLayout pipelineLayout)
+    {
+        auto compShaderCode = ReadSPIRV(compShaderPath);
+        VkShaderModule compShaderModule = CreateShaderModule(VC, compShaderCode);
+
+        VkPipelineShaderStageCreateInfo compStage{};
+        compStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        compStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        compStage.module = compShaderModule;
+        compStage.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = compStage;
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline;
+        if (vkCreateComputePipelines(VC->vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create compute pipeline");
+        }
+
+        vkDestroyShaderModule(VC->vkDevice, compShaderModule, nullptr);
+
+        return pipeline;
+    }
 }
\ No newline at end of file
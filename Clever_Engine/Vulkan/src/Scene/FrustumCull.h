@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+#include <glm.hpp>
+
+namespace Vulkan {
+    // CPU copy of the frustum test in res/cull.comp, change both together. The tests use it as the reference for the shader
+
+    // Left, right, bottom, top, near and far planes from the rows of viewProjection, depth runs 0 to 1.
+    // xyz is the unnormalized normal pointing into the frustum, w the distance term
+    inline std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProjection)
+    {
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        return { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2 };
+    }
+
+    // bounds is the mesh's bounding sphere in model space, xyz center and w radius.
+    // The radius grows with the largest axis scale of model, so non uniform scales stay conservative
+    inline bool IsInstanceVisible(const std::array<glm::vec4, 6>& planes, const glm::mat4& model, const glm::vec4& bounds)
+    {
+        glm::vec3 center(model * glm::vec4(bounds.x, bounds.y, bounds.z, 1.0f));
+        float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        float radius = bounds.w * scale;
+
+        for (const glm::vec4& plane : planes)
+        {
+            glm::vec3 normal(plane);
+            if (glm::dot(normal, center) + plane.w < -radius * glm::length(normal))
+                return false;
+        }
+        return true;
+    }
+}
@@ -43,4 +43,33 @@ namespace Vulkan {
             outFramebuffers.push_back(framebuffer);
         }
     }
+
+    // Color only, one framebuffer per view, for views into images the framebuffers do not own
+    inline void CreateFrameBuffers(
+        std::shared_ptr<VulkanCore> vulkanCore,
+        VkRenderPass renderPass,
+        const std::vector<VkImageView>& colorViews,
+        std::vector<VkFramebuffer>& outFramebuffers,
+        uint32_t width,
+        uint32_t height)
+    {
+        outFramebuffers.clear();
+        for (VkImageView view : colorViews)
+        {
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = renderPass;
+            framebufferInfo.attachmentCount = 1;
+            framebufferInfo.pAttachments = &view;
+            framebufferInfo.width = width;
+            framebufferInfo.height = height;
+            framebufferInfo.layers = 1;
+
+            VkFramebuffer framebuffer;
+            if (vkCreateFramebuffer(vulkanCore->vkDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+                throw std::runtime_error("Failed to create framebuffer!");
+
+            outFramebuffers.push_back(framebuffer);
+        }
+    }
 }
\ No newline at end of file
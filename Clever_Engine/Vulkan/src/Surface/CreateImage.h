@@ -2,6 +2,7 @@
 #include "Context/ContextVulkanData.h"
 #include <stdexcept>
 #include "Buffers/CreateBuffer.h"
+#include "Memory/MemoryAllocator.h"
 namespace Vulkan {
 
 	enum class ImageType : uint8_t {
@@ -62,16 +63,8 @@ namespace Vulkan {
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(vulkanCore.vkDevice, outImage.image, &memRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(vulkanCore.vkPhysicalDevice, memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(vulkanCore.vkDevice, &allocInfo, nullptr, &outImage.memory) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(vulkanCore.vkDevice, outImage.image, outImage.memory, 0);
+		outImage.allocation = vulkanCore.memoryAllocator->Allocate(memRequirements, properties, MemoryAllocator::ResourceKind::Image);
+		vkBindImageMemory(vulkanCore.vkDevice, outImage.image, outImage.allocation.memory, outImage.allocation.offset);
 	}
 
 	inline VkImageView createImageView(
@@ -80,7 +73,8 @@ namespace Vulkan {
 		VkFormat format,
 		VkImageAspectFlags aspectFlags,
 		VkImageViewType viewType,
-		uint32_t layers)
+		uint32_t layers,
+		uint32_t baseLayer = 0)
 	{
 		VkImageViewCreateInfo viewInfo{};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -90,7 +84,7 @@ namespace Vulkan {
 		viewInfo.subresourceRange.aspectMask = aspectFlags;
 		viewInfo.subresourceRange.baseMipLevel = 0;
 		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.baseArrayLayer = baseLayer;
 		viewInfo.subresourceRange.layerCount = layers;
 
 		VkImageView imageView;
@@ -207,15 +201,8 @@ namespace Vulkan {
 			VkMemoryRequirements memReqs;
 			vkGetImageMemoryRequirements(VC.vkDevice, img.image, &memReqs);
 
-			VkMemoryAllocateInfo allocInfo{};
-			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocInfo.allocationSize = memReqs.size;
-			allocInfo.memoryTypeIndex = FindMemoryType(VC.vkPhysicalDevice, memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-			if (vkAllocateMemory(VC.vkDevice, &allocInfo, nullptr, &img.memory) != VK_SUCCESS)
-				throw std::runtime_error("Failed to allocate dummy image memory!");
-
-			vkBindImageMemory(VC.vkDevice, img.image, img.memory, 0);
+			img.allocation = VC.memoryAllocator->Allocate(memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::ResourceKind::Image);
+			vkBindImageMemory(VC.vkDevice, img.image, img.allocation.memory, img.allocation.offset);
 
 			// --- 3. Create image view ---
 			VkImageViewCreateInfo viewInfo{};
@@ -276,7 +263,8 @@ namespace Vulkan {
 		VkFormat format,
 		VkImageLayout oldLayout,
 		VkImageLayout newLayout,
-		VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT)
+		VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		uint32_t layerCount = 1)
 	{
 		VkCommandBuffer commandBuffer = BeginSingleTimeCommands(VC);
 
@@ -291,7 +279,7 @@ namespace Vulkan {
 		barrier.subresourceRange.baseMipLevel = 0;
 		barrier.subresourceRange.levelCount = 1;
 		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
+		barrier.subresourceRange.layerCount = layerCount;
 
 		// Set access masks and pipeline stages
 		VkPipelineStageFlags sourceStage;
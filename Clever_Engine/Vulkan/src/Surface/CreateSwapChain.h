@@ -30,6 +30,7 @@ namespace Vulkan {
         glm::uvec2 windowSize;
 		VkFormat swapChainImageFormat = VK_FORMAT_UNDEFINED;
         SurfaceFlags flags = SurfaceFlags::None;
+        VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE; // Still owned by the caller, lets the driver hand its resources over
 	};
 
     inline void CreateSwapchain(std::shared_ptr<VulkanCore> VC, SwapChainCreateInfo info, VkSwapchainKHR& swapChain) {
@@ -122,6 +123,7 @@ namespace Vulkan {
         swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         swapchainCreateInfo.presentMode = presentMode;
         swapchainCreateInfo.clipped = VK_TRUE;
+        swapchainCreateInfo.oldSwapchain = info.oldSwapchain;
 
         if (vkCreateSwapchainKHR(vulkanCore.vkDevice, &swapchainCreateInfo, nullptr, &swapChain) != VK_SUCCESS) {
             throw std::runtime_error("failed to create Swap Chain!");
@@ -31,15 +31,7 @@ namespace Vulkan {
         }
 
         for (auto& depth : vulkanSurface->surfaceDepthImages) {
-            if (depth.view) {
-                vkDestroyImageView(device, depth.view, nullptr);
-            }
-            if (depth.image) {
-                vkDestroyImage(device, depth.image, nullptr);
-            }
-            if (depth.memory) {
-                vkFreeMemory(device, depth.memory, nullptr);
-            }
+            depth.Destory(vulkanCore);
         }
         vulkanSurface->surfaceDepthImages.clear();
 
@@ -53,7 +45,7 @@ namespace Vulkan {
 
         for (uint32_t i = 0; i < imageCount; ++i) {
             vulkanSurface->surfaceColorImages[i].image = images[i];
-            vulkanSurface->surfaceColorImages[i].memory = VK_NULL_HANDLE; // Owned by swapchain
+            vulkanSurface->surfaceColorImages[i].allocation = MemoryAllocation{}; // Owned by swapchain
             vulkanSurface->surfaceColorImages[i].view = VK_NULL_HANDLE;
             vulkanSurface->surfaceColorImages[i].format = vulkanSurface->surfaceswapChainImageFormat;
             vulkanSurface->surfaceColorImages[i].extent = {
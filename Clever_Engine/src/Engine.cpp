@@ -76,15 +76,18 @@ namespace Engine {
 
 		while (true)
 		{
+			//One change tick per frame, everything below writes components stamped with it
+			worldController.BeginFrame();
 			eventController.Update(renderingController.GetAllWindows());
-			worldController.Update();
+			worldController.FlushCommands();
+			worldController.Update(jobSystem);
 			sceneController.Update();
 			renderingController.Update();
 
 			if (renderingController.GetWindowCount() == 0)
 				break;
 
-			renderingController.Render(worldController.GetRegistry());
+			renderingController.Render(worldController.GetRegistry(), jobSystem);
 		}
 	}
 
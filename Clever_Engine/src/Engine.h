@@ -6,6 +6,7 @@
 #include "Scene/SceneController.h"
 #include "Event/EventController.h"
 #include "World/WorldController.h"
+#include "Jobs/JobSystem.h"
 
 #include <stdexcept>
 #include <string>
@@ -31,6 +32,7 @@ namespace Engine {
 
 		void Terminate();
 	private:
+		JobSystem jobSystem{};
 		RenderingController renderingController;
 		SceneController sceneController{};
 		EventController eventController;
@@ -0,0 +1,121 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	queues.reserve(static_cast<size_t>(workerCount) + 1);
+	for (uint32_t i = 0; i <= workerCount; ++i)
+		queues.push_back(std::make_unique<WorkQueue>());
+
+	workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void JobSystem::Push(const Job& job)
+{
+	//Workers keep their own jobs local, other threads deal them out round robin so they start spread over the cores
+	uint32_t queueIndex = currentSystem == this
+		? currentQueue
+		: 1 + nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(workers.size());
+
+	//Counted before it is visible so the count never dips below the real number of queued jobs
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+		queues[queueIndex]->jobs.push_back(job);
+	}
+
+	{
+		//Taking the lock orders this notify against a worker that just decided to sleep
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	sleepCondition.notify_one();
+}
+
+bool JobSystem::TryPop(uint32_t queueIndex, Job& job)
+{
+	WorkQueue& queue = *queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+
+	job = queue.jobs.back();
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::TrySteal(uint32_t thiefIndex, Job& job)
+{
+	uint32_t queueCount = static_cast<uint32_t>(queues.size());
+	for (uint32_t offset = 1; offset < queueCount; ++offset)
+	{
+		WorkQueue& queue = *queues[(thiefIndex + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+
+		job = queue.jobs.front();
+		queue.jobs.pop_front();
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::TryRunOne()
+{
+	uint32_t queueIndex = currentSystem == this ? currentQueue : 0;
+
+	Job job;
+	if (!TryPop(queueIndex, job) && !TrySteal(queueIndex, job))
+		return false;
+
+	queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	job.function(job.context, job.begin, job.end);
+	job.pending->fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+
+void JobSystem::Wait(std::atomic<uint32_t>& pending)
+{
+	while (pending.load(std::memory_order_acquire) != 0)
+	{
+		//Help out instead of blocking, the last jobs are usually already running elsewhere so just yield then
+		if (!TryRunOne())
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(uint32_t queueIndex)
+{
+	currentSystem = this;
+	currentQueue = queueIndex;
+
+	while (true)
+	{
+		if (TryRunOne())
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_acquire) != 0; });
+		if (stopping)
+			return;
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+//A range of work, function is called as function(context, begin, end)
+struct Job
+{
+	void (*function)(void* context, size_t begin, size_t end) = nullptr;
+	void* context = nullptr;
+	size_t begin = 0;
+	size_t end = 0;
+	std::atomic<uint32_t>* pending = nullptr;
+};
+
+/*
+Fixed pool of worker threads, one per core with the calling thread making up the last one.
+Every worker owns a deque, it pushes and pops its own work at the back while idle workers steal from the front
+of the others, so big ranges spread out and small ones stay on the core that made them.
+A thread waiting on its own jobs keeps running jobs instead of blocking, so ParallelFor can be nested.
+*/
+class JobSystem
+{
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+public:
+	//0 uses one worker per hardware thread, minus the thread that calls ParallelFor
+	explicit JobSystem(uint32_t workerCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+public:
+	/*
+	Splits [0, count) into ranges of at most grainSize and runs func(begin, end) on them across the workers.
+	Returns once every range has run, rethrowing the first exception any of them threw.
+	*/
+	template<typename Func>
+	void ParallelFor(size_t count, size_t grainSize, Func&& func)
+	{
+		if (count == 0)
+			return;
+
+		grainSize = std::max<size_t>(grainSize, 1);
+		if (workers.empty() || count <= grainSize)
+		{
+			func(size_t(0), count);
+			return;
+		}
+
+		struct Context
+		{
+			Func* func = nullptr;
+			std::exception_ptr exception{};
+			std::mutex exceptionMutex{};
+		} context;
+		context.func = &func;
+
+		auto run = [](void* data, size_t begin, size_t end)
+		{
+			Context& ctx = *static_cast<Context*>(data);
+			try
+			{
+				(*ctx.func)(begin, end);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(ctx.exceptionMutex);
+				if (!ctx.exception)
+					ctx.exception = std::current_exception();
+			}
+		};
+
+		std::atomic<uint32_t> pending = static_cast<uint32_t>((count + grainSize - 1) / grainSize);
+		for (size_t begin = 0; begin < count; begin += grainSize)
+		{
+			Push(Job{ run, &context, begin, std::min(begin + grainSize, count), &pending });
+		}
+
+		Wait(pending);
+
+		if (context.exception)
+			std::rethrow_exception(context.exception);
+	}
+
+	//Worker threads plus the calling thread
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+private:
+	void Push(const Job& job);
+	bool TryPop(uint32_t queueIndex, Job& job);
+	bool TrySteal(uint32_t thiefIndex, Job& job);
+	bool TryRunOne();
+	void Wait(std::atomic<uint32_t>& pending);
+	void WorkerLoop(uint32_t queueIndex);
+
+private:
+	//Queue 0 is shared by every thread that is not a worker, worker i owns queue i + 1
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<uint32_t> queuedJobs = 0;
+	std::atomic<uint32_t> nextQueue = 0;
+	bool stopping = false;
+
+	//Queue owned by the current thread in this system, 0 for threads that are not workers
+	static inline thread_local const JobSystem* currentSystem = nullptr;
+	static inline thread_local uint32_t currentQueue = 0;
+};
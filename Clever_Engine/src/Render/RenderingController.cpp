@@ -1,5 +1,7 @@
 #include "RenderingController.h"
 
+#include <algorithm>
+
 #include "World/ECS/Components.h"
 
 void RenderingController::Update()
@@ -14,14 +16,98 @@ void RenderingController::SetUp()
 {
 	vulkanContext = std::make_shared<Vulkan::VulkanContext>();
 	vulkanContext->Init();
+
+	//Mesh 0, what a default Visable draws
+	CreateMesh({
+		Vulkan::Vertex{ glm::vec3(1.0f, 1.0f, 0.0f) },
+		Vulkan::Vertex{ glm::vec3(-1.0f, -1.0f, 0.0f) },
+		Vulkan::Vertex{ glm::vec3(1.0f, -1.0f, 0.0f) }
+	});
 }
-void RenderingController::Render(Registry& reg)
+void RenderingController::Render(Registry& reg, JobSystem& jobSystem)
 {
-	auto& transforms = reg.GetAllComponents<Transform>();
-	int length = static_cast<int>(reg.GetAllComponents<Transform>().size());
-	for (auto& [windowID, window] : windows)
+	//Grouping moves slots around, which has to happen before the dirty ranges are collected
+	GroupVisablesByMesh(reg);
+	CollectDirtyRanges(reg);
+
+	//Instance i is the i-th Visable, the GPU buffers mirror the packed storage slot for slot
+	std::vector<Visable>& visables = reg.GetAllComponents<Visable>().GetComponents();
+	Vulkan::InstanceFrameData frameData{};
+	frameData.modelMatrices = visables.empty() ? nullptr : &visables[0].matrix;
+	frameData.matrixStride = sizeof(Visable);
+	frameData.instanceCount = static_cast<uint32_t>(visables.size());
+	frameData.dirtyRanges = dirtyRanges.data();
+	frameData.dirtyRangeCount = static_cast<uint32_t>(dirtyRanges.size());
+	frameData.groups = instanceGroups.data();
+	frameData.groupCount = static_cast<uint32_t>(instanceGroups.size());
+
+	//One scene per job, recording a scene is a lot of work next to handing it out
+	Vulkan::Window::ParallelFor parallelFor = [&jobSystem](size_t count, const std::function<void(size_t, size_t)>& func)
+	{
+		jobSystem.ParallelFor(count, 1, [&func](size_t begin, size_t end) { func(begin, end); });
+	};
+
+	//Every window goes out in the same submit and present
+	vulkanContext->Render(frameData, parallelFor);
+}
+
+void RenderingController::GroupVisablesByMesh(Registry& reg)
+{
+	ComponentStorage<Visable>& visables = reg.GetAllComponents<Visable>();
+	std::vector<Visable>& components = visables.GetComponents();
+
+	bool sorted = true;
+	uint32_t maxMeshID = 0;
+	for (size_t i = 0; i < components.size(); ++i)
+	{
+		maxMeshID = std::max(maxMeshID, components[i].meshID);
+		sorted = sorted && (i == 0 || components[i - 1].meshID <= components[i].meshID);
+	}
+
+	if (!sorted)
 	{
-		window->Render(transforms);
+		//Counting sort, stable so entities that are already in place are left alone by Reorder
+		meshOffsets.assign(static_cast<size_t>(maxMeshID) + 2, 0);
+		for (const Visable& visable : components)
+			++meshOffsets[visable.meshID + 1];
+		for (size_t i = 1; i < meshOffsets.size(); ++i)
+			meshOffsets[i] += meshOffsets[i - 1];
+
+		const std::vector<EntityID>& entities = visables.GetEntities();
+		sortedEntities.resize(components.size());
+		for (size_t i = 0; i < components.size(); ++i)
+			sortedEntities[meshOffsets[components[i].meshID]++] = entities[i];
+		visables.Reorder(sortedEntities);
+	}
+
+	instanceGroups.clear();
+	for (uint32_t i = 0; i < components.size(); ++i)
+	{
+		if (!instanceGroups.empty() && instanceGroups.back().meshID == components[i].meshID)
+			++instanceGroups.back().instanceCount;
+		else
+			instanceGroups.push_back({ components[i].meshID, i, 1 });
+	}
+}
+
+void RenderingController::CollectDirtyRanges(Registry& reg)
+{
+	//Render is the last thing in the frame to write Visables, so everything up to and including this frame's tick is read
+	ChangeTick sinceTick = lastRenderTick;
+	lastRenderTick = reg.GetTick();
+
+	ComponentStorage<Visable>& visables = reg.GetAllComponents<Visable>();
+	dirtySlots.clear();
+	reg.Changed<Visable>(sinceTick).Each([&](EntityID entity, Visable&) { dirtySlots.push_back(visables.GetSlot(entity)); });
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+
+	dirtyRanges.clear();
+	for (uint32_t slot : dirtySlots)
+	{
+		if (!dirtyRanges.empty() && dirtyRanges.back().first + dirtyRanges.back().count == slot)
+			++dirtyRanges.back().count;
+		else
+			dirtyRanges.push_back({ slot, 1 });
 	}
 }
 uint8_t RenderingController::CreateNewRenderSurface(uint8_t windowID, uint32_t width, uint32_t height, int posx, int posy)
@@ -37,7 +123,19 @@ uint8_t RenderingController::CreateNewWindow(std::string title, uint32_t width,
 {
 	auto newWindow = std::make_unique<Window>(vulkanContext, title, width, height, posx, posy);
 	newWindow->InitWindow();
+	for (const std::vector<Vulkan::Vertex>& mesh : meshes)
+		newWindow->GetVulkanWindow()->CreateMesh(mesh);
 	uint8_t windowID = newWindow->GetWindowID();
 	windows.insert({ windowID, std::move(newWindow) });
 	return windowID;
-}
\ No newline at end of file
+}
+uint32_t RenderingController::CreateMesh(const std::vector<Vulkan::Vertex>& vertices)
+{
+	for (auto& [windowID, window] : windows)
+	{
+		if (window->IsWindowStillValid())
+			window->GetVulkanWindow()->CreateMesh(vertices);
+	}
+	meshes.push_back(vertices);
+	return static_cast<uint32_t>(meshes.size()) - 1;
+}
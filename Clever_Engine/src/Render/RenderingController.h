@@ -11,6 +11,7 @@
 #include "Context/VulkanContext.h"
 
 #include "World/ECS/Registry.h"
+#include "Jobs/JobSystem.h"
 
 class RenderingController
 {
@@ -21,7 +22,8 @@ public:
 public:
 	void Update();
 	void SetUp();
-	void Render(Registry& reg);
+	//Windows record their scenes across jobSystem
+	void Render(Registry& reg, JobSystem& jobSystem);
 
 	//This is a scene and shouldnt be called on its own, only when creating a new scene will a new render surface be created
 	uint8_t CreateNewRenderSurface(uint8_t windowID, uint32_t width, uint32_t height, int posx = 0, int posy = 0);
@@ -32,6 +34,9 @@ public:
 	//Deletes render Surface, this should NOT be called directly, only when deleting a scene will a render surface be deleted
 	void DeleteRenderSurface(int renderSurfaceID);
 
+	//Uploads the mesh to every window, current and future. The returned ID goes in Visable::meshID
+	uint32_t CreateMesh(const std::vector<Vulkan::Vertex>& vertices);
+
 	uint8_t GetNextRenderSurfaceID() { return nextRenderSurfaceID++; }
 
 	RenderSurface& GetRenderSurface(uint8_t renderSurfaceID)
@@ -60,9 +65,26 @@ public:
 		return static_cast<int>(windows.size());
 	}
 
+private:
+	//Sorts the Visable storage by mesh so every mesh is one contiguous run of instances, then fills instanceGroups
+	void GroupVisablesByMesh(Registry& reg);
+	//Turns the Visable slots changed since the last Render into sorted, merged ranges
+	void CollectDirtyRanges(Registry& reg);
+
 private:
 	uint8_t nextRenderSurfaceID = 1;
 
+	ChangeTick lastRenderTick = 0;
+	std::vector<uint32_t> dirtySlots;
+	std::vector<Vulkan::DirtyRange> dirtyRanges;
+
+	//Every mesh created so far, replayed into windows created later so mesh IDs match across windows
+	std::vector<std::vector<Vulkan::Vertex>> meshes;
+	std::vector<Vulkan::InstanceGroup> instanceGroups;
+	//Scratch for GroupVisablesByMesh
+	std::vector<uint32_t> meshOffsets;
+	std::vector<EntityID> sortedEntities;
+
 	std::map<uint8_t, std::unique_ptr<RenderSurface>> renderSurfaces;
 	std::map<uint8_t, std::unique_ptr<Window>> windows;
 	std::shared_ptr<Vulkan::VulkanContext> vulkanContext;
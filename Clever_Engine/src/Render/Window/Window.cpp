@@ -81,12 +81,6 @@ void Window::InitWindow()
 		GetVulkanWindow()->InitWindow(p_GLFWWindow);
 }
 
-void Window::Render(std::unordered_map<uint32_t, Transform>& transforms)
-{
-	if (IsWindowStillValid())
-		GetVulkanWindow()->RenderScenes(transforms, length);
-}
-
 void Window::CloseWindow()
 {
 	GetVulkanWindow()->CloseWindow();
@@ -0,0 +1,202 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+
+#include "ComponentStorage.h"
+
+//Size of one block of archetype storage, small enough that a chunk being streamed stays in L1/L2
+constexpr size_t ArchetypeChunkSize = 16 * 1024;
+constexpr uint32_t NoArchetype = std::numeric_limits<uint32_t>::max();
+
+//Type-erased description of a component so an Archetype can lay out and manage columns of any type
+struct ComponentTypeInfo
+{
+	uint32_t family = 0;
+	size_t size = 0;
+	size_t align = 0;
+	void (*copyConstruct)(void* dst, const void* src) = nullptr;
+	void (*moveConstruct)(void* dst, void* src) = nullptr;
+	void (*destroy)(void* ptr) = nullptr;
+
+	template<typename ComponentType>
+	static ComponentTypeInfo Of()
+	{
+		ComponentTypeInfo info{};
+		info.family = ComponentFamily::ID<ComponentType>();
+		info.size = sizeof(ComponentType);
+		info.align = alignof(ComponentType);
+		info.copyConstruct = [](void* dst, const void* src) { new (dst) ComponentType(*static_cast<const ComponentType*>(src)); };
+		info.moveConstruct = [](void* dst, void* src) { new (dst) ComponentType(std::move(*static_cast<ComponentType*>(src))); };
+		info.destroy = [](void* ptr) { static_cast<ComponentType*>(ptr)->~ComponentType(); };
+		return info;
+	}
+};
+
+//Where an archetype entity lives, archetype is NoArchetype for entities in the per-type sparse sets
+struct ArchetypeLocation
+{
+	uint32_t archetype = NoArchetype;
+	uint32_t chunk = 0;
+	uint32_t row = 0;
+};
+
+/*
+All entities with exactly the same component set, stored in fixed size chunks.
+Each chunk is SoA: an EntityID column followed by one tightly packed column per component,
+so a system touching several components streams each column linearly.
+Entities are kept packed, removing one moves the very last entity into the hole.
+*/
+class Archetype
+{
+	struct alignas(64) ChunkMemory
+	{
+		std::byte bytes[ArchetypeChunkSize];
+	};
+	struct Chunk
+	{
+		std::unique_ptr<ChunkMemory> memory = std::make_unique<ChunkMemory>();
+		uint32_t count = 0;
+	};
+public:
+	Archetype(ComponentSignature signature, std::vector<ComponentTypeInfo> componentTypes)
+		: signature(signature), types(std::move(componentTypes))
+	{
+		std::sort(types.begin(), types.end(), [](const ComponentTypeInfo& a, const ComponentTypeInfo& b) { return a.family < b.family; });
+
+		size_t bytesPerEntity = sizeof(EntityID);
+		for (const ComponentTypeInfo& type : types)
+			bytesPerEntity += type.size;
+
+		//Start from the ideal row count and back off until the aligned columns fit in one chunk
+		chunkCapacity = static_cast<uint32_t>(ArchetypeChunkSize / bytesPerEntity);
+		while (chunkCapacity > 0 && !ComputeLayout(chunkCapacity))
+			--chunkCapacity;
+
+		if (chunkCapacity == 0)
+			throw std::runtime_error("Archetype components do not fit in a single chunk!");
+
+		columnByFamily.assign(MaxComponentTypes, NoColumn);
+		for (uint32_t column = 0; column < types.size(); ++column)
+			columnByFamily[types[column].family] = column;
+	}
+	~Archetype()
+	{
+		for (Chunk& chunk : chunks)
+		{
+			for (uint32_t column = 0; column < types.size(); ++column)
+			{
+				for (uint32_t row = 0; row < chunk.count; ++row)
+					types[column].destroy(ColumnElement(chunk, column, row));
+			}
+		}
+	}
+	Archetype(const Archetype&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+
+public:
+	//Reserves a row for entity at the end of the last chunk, the caller must construct every component with Construct
+	ArchetypeLocation Allocate(EntityID entity, uint32_t archetypeIndex)
+	{
+		if (chunks.empty() || chunks.back().count == chunkCapacity)
+			chunks.emplace_back();
+
+		Chunk& chunk = chunks.back();
+		uint32_t row = chunk.count++;
+		EntityColumn(chunk)[row] = entity;
+		return { archetypeIndex, static_cast<uint32_t>(chunks.size() - 1), row };
+	}
+
+	void Construct(uint32_t family, const ArchetypeLocation& location, const void* component)
+	{
+		uint32_t column = columnByFamily[family];
+		types[column].copyConstruct(ColumnElement(chunks[location.chunk], column, location.row), component);
+	}
+
+	//Destroys the row and fills it with the last entity, returns the entity that moved or NullEntity if none did
+	EntityID Remove(const ArchetypeLocation& location)
+	{
+		Chunk& chunk = chunks[location.chunk];
+		Chunk& lastChunk = chunks.back();
+		uint32_t lastRow = lastChunk.count - 1;
+		bool isLast = &chunk == &lastChunk && location.row == lastRow;
+
+		EntityID moved = NullEntity;
+		for (uint32_t column = 0; column < types.size(); ++column)
+		{
+			void* hole = ColumnElement(chunk, column, location.row);
+			types[column].destroy(hole);
+			if (!isLast)
+			{
+				void* last = ColumnElement(lastChunk, column, lastRow);
+				types[column].moveConstruct(hole, last);
+				types[column].destroy(last);
+			}
+		}
+		if (!isLast)
+		{
+			moved = EntityColumn(lastChunk)[lastRow];
+			EntityColumn(chunk)[location.row] = moved;
+		}
+
+		if (--lastChunk.count == 0)
+			chunks.pop_back();
+
+		return moved;
+	}
+
+	void* GetComponent(uint32_t family, const ArchetypeLocation& location)
+	{
+		return ColumnElement(chunks[location.chunk], columnByFamily[family], location.row);
+	}
+
+	bool HasFamily(uint32_t family) const { return signature.test(family); }
+
+	template<typename ComponentType>
+	ComponentType* GetColumn(uint32_t chunkIndex)
+	{
+		return reinterpret_cast<ComponentType*>(chunks[chunkIndex].memory->bytes + columnOffsets[columnByFamily[ComponentFamily::ID<ComponentType>()]]);
+	}
+	const EntityID* GetEntities(uint32_t chunkIndex) { return EntityColumn(chunks[chunkIndex]); }
+
+	uint32_t GetChunkCount() const { return static_cast<uint32_t>(chunks.size()); }
+	uint32_t GetChunkEntityCount(uint32_t chunkIndex) const { return chunks[chunkIndex].count; }
+	uint32_t GetChunkCapacity() const { return chunkCapacity; }
+	const ComponentSignature& GetSignature() const { return signature; }
+
+private:
+	static constexpr uint32_t NoColumn = std::numeric_limits<uint32_t>::max();
+
+	bool ComputeLayout(uint32_t capacity)
+	{
+		columnOffsets.clear();
+		size_t offset = sizeof(EntityID) * capacity;
+		for (const ComponentTypeInfo& type : types)
+		{
+			offset = (offset + type.align - 1) & ~(type.align - 1);
+			columnOffsets.push_back(offset);
+			offset += type.size * capacity;
+		}
+		return offset <= ArchetypeChunkSize;
+	}
+
+	EntityID* EntityColumn(Chunk& chunk)
+	{
+		return reinterpret_cast<EntityID*>(chunk.memory->bytes);
+	}
+	void* ColumnElement(Chunk& chunk, uint32_t column, uint32_t row)
+	{
+		return chunk.memory->bytes + columnOffsets[column] + types[column].size * row;
+	}
+
+private:
+	ComponentSignature signature;
+	std::vector<ComponentTypeInfo> types;
+	std::vector<size_t> columnOffsets;
+	std::vector<uint32_t> columnByFamily;
+	std::vector<Chunk> chunks;
+	uint32_t chunkCapacity = 0;
+};
@@ -0,0 +1,316 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <atomic>
+#include <bitset>
+#include <algorithm>
+#include <span>
+#include <cassert>
+
+#include "Entity.h"
+
+/*
+Hands out a small dense index per component type the first time that type is seen.
+Registry uses it to index its storages directly instead of hashing a std::type_index.
+*/
+class ComponentFamily
+{
+public:
+	template<typename ComponentType>
+	static uint32_t ID()
+	{
+		static const uint32_t id = nextID++;
+		return id;
+	}
+private:
+	static inline std::atomic<uint32_t> nextID = 0;
+};
+
+//One bit per ComponentFamily ID, bit N is set when the entity owns the component with family N
+constexpr uint32_t MaxComponentTypes = 64;
+using ComponentSignature = std::bitset<MaxComponentTypes>;
+
+//Registry tick an entity's component was last written in, 0 means never
+using ChangeTick = uint32_t;
+
+struct ComponentStorageI
+{
+	virtual ~ComponentStorageI() = default;
+	virtual void Remove(EntityID entity) = 0;
+	virtual bool Has(EntityID entity) const = 0;
+	//Changes from here on are stamped with tick, history at or before forgetThrough is dropped
+	virtual void SetTick(ChangeTick tick, ChangeTick forgetThrough) = 0;
+};
+
+/*
+Sparse set storage. Components live packed in a dense array so systems walk contiguous memory,
+the sparse array maps an entity index to its slot in the dense array. The dense entity array keeps the full
+generational handle so a recycled index with a stale version is never reported as present.
+
+Every slot also carries the tick it was last changed in, and the first change of an entity in a tick is appended
+to a change log ordered by tick, so "what changed since tick N" costs the number of changes, not the storage size.
+The log always has room for every entity to log once more in the current tick, so parallel writers append
+with one atomic add instead of taking a lock.
+*/
+template<typename ComponentType>
+class ComponentStorage : public ComponentStorageI
+{
+public:
+	static constexpr uint32_t Tombstone = std::numeric_limits<uint32_t>::max();
+
+	struct ChangeRecord
+	{
+		EntityID entity;
+		ChangeTick tick;
+	};
+
+	class Iterator
+	{
+	public:
+		Iterator(ComponentStorage* storage, size_t index) : storage(storage), index(index) {}
+
+		std::pair<EntityID, ComponentType&> operator*() const
+		{
+			return { storage->entities[index], storage->components[index] };
+		}
+		Iterator& operator++() { ++index; return *this; }
+		bool operator!=(const Iterator& other) const { return index != other.index; }
+	private:
+		ComponentStorage* storage;
+		size_t index;
+	};
+public:
+	ComponentStorage() = default;
+	~ComponentStorage() override = default;
+public:
+	//Swap-removes so the dense arrays stay packed, the moved component counts as changed for anything mirroring slots
+	void Remove(EntityID entity) override
+	{
+		if (!Has(entity))
+			return;
+
+		uint32_t entityIndex = GetEntityIndex(entity);
+		uint32_t index = sparse[entityIndex];
+		uint32_t last = static_cast<uint32_t>(components.size()) - 1;
+		if (index != last)
+		{
+			components[index] = std::move(components[last]);
+			entities[index] = entities[last];
+			changeTicks[index] = changeTicks[last];
+			sparse[GetEntityIndex(entities[index])] = index;
+			MarkSlotChanged(index);
+		}
+		components.pop_back();
+		entities.pop_back();
+		changeTicks.pop_back();
+		sparse[entityIndex] = Tombstone;
+	}
+	bool Has(EntityID entity) const override
+	{
+		uint32_t entityIndex = GetEntityIndex(entity);
+		return entityIndex < sparse.size() && sparse[entityIndex] != Tombstone && entities[sparse[entityIndex]] == entity;
+	}
+	ComponentType& Set(EntityID entity, const ComponentType& component = ComponentType())
+	{
+		uint32_t entityIndex = GetEntityIndex(entity);
+		if (entityIndex < sparse.size() && sparse[entityIndex] != Tombstone)
+		{
+			//Either the same entity or a stale handle's leftovers in a recycled slot, both get overwritten
+			uint32_t index = sparse[entityIndex];
+			entities[index] = entity;
+			MarkSlotChanged(index);
+			return components[index] = component;
+		}
+		if (entityIndex >= sparse.size())
+		{
+			sparse.resize(static_cast<size_t>(entityIndex) + 1, Tombstone);
+		}
+		sparse[entityIndex] = static_cast<uint32_t>(components.size());
+		entities.push_back(entity);
+		components.push_back(component);
+		changeTicks.push_back(0);
+		ReserveChangeLog(components.size());
+		MarkSlotChanged(sparse[entityIndex]);
+		return components.back();
+	}
+	//Bulk Set of the same component value on every entity, the sparse and dense arrays grow at most once
+	void SetMany(const EntityID* newEntities, size_t count, const ComponentType& component)
+	{
+		uint32_t maxIndex = 0;
+		for (size_t i = 0; i < count; ++i)
+			maxIndex = std::max(maxIndex, GetEntityIndex(newEntities[i]));
+		if (maxIndex >= sparse.size())
+		{
+			sparse.resize(static_cast<size_t>(maxIndex) + 1, Tombstone);
+		}
+		Reserve(components.size() + count);
+		ReserveChangeLog(components.size() + count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t entityIndex = GetEntityIndex(newEntities[i]);
+			if (sparse[entityIndex] != Tombstone)
+			{
+				uint32_t index = sparse[entityIndex];
+				entities[index] = newEntities[i];
+				components[index] = component;
+				MarkSlotChanged(index);
+				continue;
+			}
+			sparse[entityIndex] = static_cast<uint32_t>(components.size());
+			entities.push_back(newEntities[i]);
+			components.push_back(component);
+			changeTicks.push_back(0);
+			MarkSlotChanged(sparse[entityIndex]);
+		}
+	}
+	//Makes room for count components in total without reallocating the dense arrays
+	void Reserve(size_t count)
+	{
+		components.reserve(count);
+		entities.reserve(count);
+		changeTicks.reserve(count);
+	}
+	ComponentType& Get(EntityID entity)
+	{
+		if (!Has(entity))
+			throw std::out_of_range("Entity does not have this component!");
+		return components[sparse[GetEntityIndex(entity)]];
+	}
+	//No Has probe, caller must already know the entity owns this component
+	ComponentType& GetUnchecked(EntityID entity)
+	{
+		return components[sparse[GetEntityIndex(entity)]];
+	}
+	//Index of the entity's component in GetComponents(), caller must already know the entity owns this component
+	uint32_t GetSlot(EntityID entity) const
+	{
+		return sparse[GetEntityIndex(entity)];
+	}
+
+	/*
+	Moves the listed entities to the front of the dense arrays in the given order, everything else follows in no particular order.
+	Entities without this component are skipped. Already sorted entries are not touched, so re-sorting a stable order is one pass.
+	Moved components count as changed, so copies indexed by slot (like the renderer's matrix buffer) pick up the new layout.
+	*/
+	void Reorder(const std::vector<EntityID>& order)
+	{
+		uint32_t slot = 0;
+		for (EntityID entity : order)
+		{
+			if (!Has(entity))
+				continue;
+
+			uint32_t from = sparse[GetEntityIndex(entity)];
+			if (from != slot)
+				SwapSlots(from, slot);
+			++slot;
+		}
+	}
+
+	//Call after writing to a component in place. Safe from parallel systems as long as each entity is marked by one thread
+	void MarkChanged(EntityID entity)
+	{
+		if (Has(entity))
+			MarkSlotChanged(sparse[GetEntityIndex(entity)]);
+	}
+	ChangeTick GetChangeTick(EntityID entity) const
+	{
+		return Has(entity) ? changeTicks[sparse[GetEntityIndex(entity)]] : 0;
+	}
+
+	void SetTick(ChangeTick tick, ChangeTick forgetThrough) override
+	{
+		currentTick = tick;
+		if (forgetThrough > forgottenThrough)
+		{
+			auto logEnd = changeLog.begin() + changeLogSize.load(std::memory_order_relaxed);
+			auto firstKept = std::upper_bound(changeLog.begin(), logEnd, forgetThrough,
+				[](ChangeTick value, const ChangeRecord& record) { return value < record.tick; });
+			auto keptEnd = std::move(firstKept, logEnd, changeLog.begin());
+			changeLogSize.store(static_cast<size_t>(keptEnd - changeLog.begin()), std::memory_order_relaxed);
+			forgottenThrough = forgetThrough;
+		}
+		ReserveChangeLog(components.size());
+	}
+
+	//True when every change after sinceTick is still in the change log
+	bool HasChangeHistorySince(ChangeTick sinceTick) const { return sinceTick >= forgottenThrough; }
+
+	//First record in GetChangeLog() changed after sinceTick
+	size_t FirstChangeSince(ChangeTick sinceTick) const
+	{
+		std::span<const ChangeRecord> log = GetChangeLog();
+		auto first = std::upper_bound(log.begin(), log.end(), sinceTick,
+			[](ChangeTick value, const ChangeRecord& record) { return value < record.tick; });
+		return static_cast<size_t>(first - log.begin());
+	}
+
+	//A record is only live if the entity still owns the component and has not changed again in a later tick
+	bool IsLatestChange(const ChangeRecord& record) const
+	{
+		return Has(record.entity) && changeTicks[sparse[GetEntityIndex(record.entity)]] == record.tick;
+	}
+
+	size_t size() const { return components.size(); }
+	Iterator begin() { return Iterator(this, 0); }
+	Iterator end() { return Iterator(this, components.size()); }
+
+	//Packed component array, index i belongs to GetEntities()[i]
+	std::vector<ComponentType>& GetComponents() { return components; }
+	const std::vector<EntityID>& GetEntities() const { return entities; }
+	//Parallel to GetComponents()
+	const std::vector<ChangeTick>& GetChangeTicks() const { return changeTicks; }
+	std::span<const ChangeRecord> GetChangeLog() const { return { changeLog.data(), changeLogSize.load(std::memory_order_relaxed) }; }
+	ComponentStorage& GetAll() { return *this; }
+
+	//Held by ChangedView while it walks the storage, marking a change meanwhile would edit what it is walking
+	void BeginChangeRead() { changeReaders.fetch_add(1, std::memory_order_relaxed); }
+	void EndChangeRead() { changeReaders.fetch_sub(1, std::memory_order_relaxed); }
+private:
+	void SwapSlots(uint32_t a, uint32_t b)
+	{
+		std::swap(components[a], components[b]);
+		std::swap(entities[a], entities[b]);
+		std::swap(changeTicks[a], changeTicks[b]);
+		sparse[GetEntityIndex(entities[a])] = a;
+		sparse[GetEntityIndex(entities[b])] = b;
+		MarkSlotChanged(a);
+		MarkSlotChanged(b);
+	}
+	void MarkSlotChanged(uint32_t index)
+	{
+		assert(changeReaders.load(std::memory_order_relaxed) == 0 && "Cannot mark changes while a ChangedView walks the same storage");
+
+		//Only the first change of a tick is logged, later ones in the same tick just match it
+		if (changeTicks[index] == currentTick)
+			return;
+
+		//ReserveChangeLog left room for this, every entity logs at most once per tick
+		changeTicks[index] = currentTick;
+		size_t at = changeLogSize.fetch_add(1, std::memory_order_relaxed);
+		changeLog[at] = { entities[index], currentTick };
+	}
+	//Makes sure slots more records fit past the end of the log, only called while nothing marks changes in parallel
+	void ReserveChangeLog(size_t slots)
+	{
+		size_t needed = changeLogSize.load(std::memory_order_relaxed) + slots;
+		if (needed > changeLog.size())
+			changeLog.resize(std::max(needed, changeLog.size() * 2));
+	}
+private:
+	std::vector<ComponentType> components;
+	std::vector<EntityID> entities;
+	std::vector<uint32_t> sparse;
+
+	std::vector<ChangeTick> changeTicks;
+	//Only the first changeLogSize records are in use, the rest is room for this tick's changes
+	std::vector<ChangeRecord> changeLog;
+	std::atomic<size_t> changeLogSize = 0;
+	std::atomic<uint32_t> changeReaders = 0;
+	ChangeTick currentTick = 1;
+	ChangeTick forgottenThrough = 0;
+};
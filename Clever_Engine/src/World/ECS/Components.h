@@ -1,11 +1,26 @@
 #pragma once
 #include <glm.hpp>
+#include <vector>
 
 #include "Objects/Vertex.h"
+#include "Entity.h"
 
 //If an entity has this component it will be rendered
 struct Visable
 {
 	glm::mat4 matrix{1.0f};
-	bool isDirty = true;
-};
\ No newline at end of file
+	//From RenderingController::CreateMesh, 0 is the built in triangle
+	uint32_t meshID = 0;
+};
+
+//The entity's Transform is relative to this entity, set through WorldController::SetParent
+struct Parent
+{
+	EntityID entity = NullEntity;
+};
+
+//Direct children of the entity, kept in sync with their Parent components by the HierarchySystem
+struct Children
+{
+	std::vector<EntityID> entities;
+};
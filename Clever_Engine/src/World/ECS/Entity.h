@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+/*
+An EntityID is a generational handle: the low bits are the slot index that storages key their sparse arrays on,
+the high bits are a version that is bumped every time the slot is recycled so stale handles can be detected.
+*/
+using EntityID = uint32_t;
+
+constexpr uint32_t EntityIndexBits = 20;
+constexpr uint32_t EntityVersionBits = 12;
+constexpr uint32_t EntityIndexMask = (1u << EntityIndexBits) - 1;
+constexpr uint32_t EntityVersionMask = (1u << EntityVersionBits) - 1;
+
+//Index 0 is never handed out, so a zeroed EntityID is always invalid
+constexpr EntityID NullEntity = 0;
+
+constexpr uint32_t GetEntityIndex(EntityID entity)
+{
+	return entity & EntityIndexMask;
+}
+
+constexpr uint32_t GetEntityVersion(EntityID entity)
+{
+	return (entity >> EntityIndexBits) & EntityVersionMask;
+}
+
+constexpr EntityID MakeEntityID(uint32_t index, uint32_t version)
+{
+	return (index & EntityIndexMask) | ((version & EntityVersionMask) << EntityIndexBits);
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+
+#include "Registry.h"
+
+//Entity created through an EntityCommandBuffer, it only becomes a real EntityID at Playback
+struct DeferredEntity
+{
+	uint32_t arena = 0;
+	uint32_t index = 0;
+};
+
+/*
+Records structural changes (create, destroy, add component, remove component) from any thread
+and applies them to the Registry in one batched pass at a sync point, so nothing mutates the Registry mid frame.
+Every recording thread gets its own arena. Arena blocks are kept between frames so once warmed up, recording
+is a bump allocation with no locking and no heap allocation.
+Playback goes arena by arena, so commands keep the order their own thread recorded them in, but commands from
+different threads apply in arena order, not in the order they were recorded. Two threads changing the same
+entity must not rely on which one wins.
+Recording and Playback must not overlap.
+*/
+class EntityCommandBuffer
+{
+	static constexpr size_t BlockSize = 64 * 1024;
+	static constexpr size_t CommandAlignment = alignof(std::max_align_t);
+
+	struct CommandTarget
+	{
+		EntityID entity = NullEntity;
+		DeferredEntity deferred{};
+		bool isDeferred = false;
+	};
+
+	struct CommandHeader
+	{
+		CommandTarget target;
+		size_t size = 0; //Header plus payload, aligned to CommandAlignment
+		void (*apply)(Registry& registry, EntityID entity, void* payload) = nullptr;
+		void (*destroy)(void* payload) = nullptr;
+	};
+
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> memory;
+		size_t capacity = 0;
+		size_t used = 0;
+	};
+
+	struct Arena
+	{
+		std::thread::id owner;
+		uint32_t index = 0;
+		std::vector<Block> blocks;
+		size_t currentBlock = 0;
+		uint32_t deferredCount = 0;
+		std::vector<EntityID> createdEntities;
+	};
+
+public:
+	EntityCommandBuffer() : bufferID(nextBufferID++) {}
+	EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+	~EntityCommandBuffer()
+	{
+		for (auto& arena : arenas)
+			Reset(*arena);
+	}
+
+public:
+	DeferredEntity CreateEntity()
+	{
+		Arena& arena = GetThreadArena();
+		return DeferredEntity{ arena.index, arena.deferredCount++ };
+	}
+
+	void DestroyEntity(EntityID entity) { RecordDestroy(CommandTarget{ entity }); }
+	void DestroyEntity(DeferredEntity entity) { RecordDestroy(CommandTarget{ NullEntity, entity, true }); }
+
+	template<typename ComponentType>
+	void AddComponent(EntityID entity, const ComponentType& component) { RecordAdd(CommandTarget{ entity }, component); }
+	template<typename ComponentType>
+	void AddComponent(DeferredEntity entity, const ComponentType& component) { RecordAdd(CommandTarget{ NullEntity, entity, true }, component); }
+
+	template<typename ComponentType>
+	void RemoveComponent(EntityID entity) { RecordRemove<ComponentType>(CommandTarget{ entity }); }
+	template<typename ComponentType>
+	void RemoveComponent(DeferredEntity entity) { RecordRemove<ComponentType>(CommandTarget{ NullEntity, entity, true }); }
+
+	/*
+	Applies every recorded command on the calling thread, then clears the buffer for the next frame.
+	Commands aimed at an entity that is no longer alive, e.g. destroyed earlier in the same playback, are skipped.
+	The buffer is cleared even if a command throws, so nothing is applied twice.
+	*/
+	void Playback(Registry& registry)
+	{
+		std::lock_guard<std::mutex> lock(arenaMutex);
+		struct ResetOnExit
+		{
+			EntityCommandBuffer& buffer;
+			~ResetOnExit()
+			{
+				for (auto& arena : buffer.arenas)
+					buffer.Reset(*arena);
+			}
+		} resetOnExit{ *this };
+
+		//Create every deferred entity first so commands from one thread can target entities created on another
+		for (auto& arena : arenas)
+		{
+			arena->createdEntities.resize(arena->deferredCount);
+			for (uint32_t i = 0; i < arena->deferredCount; ++i)
+				arena->createdEntities[i] = registry.CreateEntity();
+		}
+
+		for (auto& arena : arenas)
+		{
+			ForEachCommand(*arena, [&](CommandHeader& header, void* payload)
+			{
+				EntityID entity = header.target.isDeferred
+					? arenas[header.target.deferred.arena]->createdEntities[header.target.deferred.index]
+					: header.target.entity;
+				if (registry.IsAlive(entity))
+					header.apply(registry, entity, payload);
+			});
+		}
+	}
+
+private:
+	void RecordDestroy(const CommandTarget& target)
+	{
+		CommandHeader& header = Allocate(0, nullptr);
+		header.target = target;
+		header.apply = [](Registry& registry, EntityID entity, void*) { registry.RemoveEntity(entity); };
+	}
+
+	template<typename ComponentType>
+	void RecordAdd(const CommandTarget& target, const ComponentType& component)
+	{
+		static_assert(alignof(ComponentType) <= CommandAlignment, "Over aligned components cannot be recorded");
+
+		void* payload = nullptr;
+		CommandHeader& header = Allocate(sizeof(ComponentType), &payload);
+		new (payload) ComponentType(component);
+		header.target = target;
+		header.apply = [](Registry& registry, EntityID entity, void* data) { registry.SetComponent(entity, *static_cast<ComponentType*>(data)); };
+		header.destroy = [](void* data) { static_cast<ComponentType*>(data)->~ComponentType(); };
+	}
+
+	template<typename ComponentType>
+	void RecordRemove(const CommandTarget& target)
+	{
+		CommandHeader& header = Allocate(0, nullptr);
+		header.target = target;
+		header.apply = [](Registry& registry, EntityID entity, void*) { registry.RemoveComponent<ComponentType>(entity); };
+	}
+
+	static constexpr size_t AlignUp(size_t value)
+	{
+		return (value + CommandAlignment - 1) & ~(CommandAlignment - 1);
+	}
+
+	CommandHeader& Allocate(size_t payloadSize, void** outPayload)
+	{
+		Arena& arena = GetThreadArena();
+		size_t headerSize = AlignUp(sizeof(CommandHeader));
+		size_t total = headerSize + AlignUp(payloadSize);
+
+		//Move on to the next kept block, only allocating when every block so far is full
+		while (arena.currentBlock < arena.blocks.size() &&
+			arena.blocks[arena.currentBlock].used + total > arena.blocks[arena.currentBlock].capacity)
+		{
+			++arena.currentBlock;
+		}
+		if (arena.currentBlock == arena.blocks.size())
+		{
+			Block block{};
+			block.capacity = std::max(BlockSize, total);
+			block.memory = std::make_unique<std::byte[]>(block.capacity);
+			arena.blocks.push_back(std::move(block));
+		}
+
+		Block& block = arena.blocks[arena.currentBlock];
+		std::byte* base = block.memory.get() + block.used;
+		block.used += total;
+
+		CommandHeader* header = new (base) CommandHeader{};
+		header->size = total;
+		if (outPayload)
+			*outPayload = base + headerSize;
+		return *header;
+	}
+
+	template<typename Func>
+	void ForEachCommand(Arena& arena, Func&& func)
+	{
+		size_t headerSize = AlignUp(sizeof(CommandHeader));
+		for (Block& block : arena.blocks)
+		{
+			size_t offset = 0;
+			while (offset < block.used)
+			{
+				CommandHeader* header = reinterpret_cast<CommandHeader*>(block.memory.get() + offset);
+				func(*header, block.memory.get() + offset + headerSize);
+				offset += header->size;
+			}
+		}
+	}
+
+	void Reset(Arena& arena)
+	{
+		ForEachCommand(arena, [](CommandHeader& header, void* payload)
+		{
+			if (header.destroy)
+				header.destroy(payload);
+		});
+		for (Block& block : arena.blocks)
+			block.used = 0;
+		arena.currentBlock = 0;
+		arena.deferredCount = 0;
+		arena.createdEntities.clear();
+	}
+
+	//Only takes the lock the first time a thread records into this buffer, the arena itself never moves
+	Arena& GetThreadArena()
+	{
+		if (arenaCache.bufferID == bufferID)
+			return *arenaCache.arena;
+
+		std::lock_guard<std::mutex> lock(arenaMutex);
+		std::thread::id self = std::this_thread::get_id();
+		uint32_t index = 0;
+		while (index < arenas.size() && arenas[index]->owner != self)
+			++index;
+
+		if (index == arenas.size())
+		{
+			arenas.push_back(std::make_unique<Arena>());
+			arenas.back()->owner = self;
+			arenas.back()->index = index;
+		}
+
+		arenaCache = { bufferID, arenas[index].get() };
+		return *arenas[index];
+	}
+
+private:
+	struct ArenaCache
+	{
+		uint64_t bufferID;
+		Arena* arena;
+	};
+	//Per thread, remembers the arena of the last buffer this thread recorded into. Zero initialized, buffer IDs start at 1
+	static inline thread_local ArenaCache arenaCache;
+	static inline std::atomic<uint64_t> nextBufferID = 1;
+
+	uint64_t bufferID;
+	std::mutex arenaMutex;
+	std::vector<std::unique_ptr<Arena>> arenas;
+};
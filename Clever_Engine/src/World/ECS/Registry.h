@@ -1,79 +1,216 @@
 #pragma once
 #include <memory>
-#include <unordered_map>
-#include <typeindex>
+#include <vector>
 #include <stdexcept>
+#include <bit>
+#include <unordered_map>
 
-using EntityID = uint32_t;
+#include "ComponentStorage.h"
+#include "Archetype.h"
+#include "View.h"
 
-struct ComponentStorageI
+//Where the components of a new entity are stored
+enum class StoragePolicy
 {
-	virtual ~ComponentStorageI() = default;
-	virtual void Remove(EntityID entity) = 0;
-	virtual bool Has(EntityID entity) const = 0;
+	SparseSet, //One packed array per component type, components can be added and removed freely
+	Archetype  //Chunked SoA storage per component set, the set is fixed once the entity is created
 };
 
-template<typename ComponentType>
-class ComponentStorage : public ComponentStorageI
+class Registry
 {
 public:
-	ComponentStorage() = default;
-	~ComponentStorage() override = default;
+	Registry() = default;
+	~Registry() = default;
+
 public:
-	void Remove(EntityID entity) override
+	//This returns an unique EntityID, recycling the index of a removed entity when one is free
+	EntityID CreateEntity()
 	{
-		data.erase(entity);
+		uint32_t index;
+		if (!freeEntityIndices.empty())
+		{
+			index = freeEntityIndices.back();
+			freeEntityIndices.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(entityVersions.size());
+			if (index > EntityIndexMask)
+				throw std::runtime_error("Registry ran out of entity indices!");
+			entityVersions.push_back(0);
+			entitySignatures.emplace_back();
+			entityLocations.emplace_back();
+		}
+		return MakeEntityID(index, entityVersions[index]);
 	}
-	bool Has(EntityID entity) const override
+
+	//Creates an entity with the given components using the chosen storage layout
+	template<typename... ComponentTypes>
+	EntityID CreateEntity(StoragePolicy policy, const ComponentTypes&... components)
 	{
-		return data.find(entity) != data.end();
+		if (policy == StoragePolicy::Archetype)
+			return CreateArchetypeEntity(components...);
+
+		EntityID entity = CreateEntity();
+		(SetComponent(entity, components), ...);
+		return entity;
 	}
-	ComponentType& Set(EntityID entity, const ComponentType& component = ComponentType())
+
+	/*
+	Creates count entities that all start with copies of the given components.
+	Entity arrays and component storages are grown once up front and every column is written in a single pass,
+	instead of count separate CreateEntity/SetComponent calls each possibly reallocating.
+	*/
+	template<typename... ComponentTypes>
+	std::vector<EntityID> CreateEntities(size_t count, const ComponentTypes&... components)
 	{
-		return data[entity] = component;
+		std::vector<EntityID> entities(count);
+		ReserveEntities(count);
+		for (size_t i = 0; i < count; ++i)
+			entities[i] = CreateEntity();
+
+		if constexpr (sizeof...(ComponentTypes) > 0)
+		{
+			ComponentSignature signature = MakeSignature<ComponentTypes...>();
+			for (EntityID entity : entities)
+				entitySignatures[GetEntityIndex(entity)] = signature;
+
+			(GetStorage<ComponentTypes>().SetMany(entities.data(), count, components), ...);
+		}
+		return entities;
 	}
-	ComponentType& Get(EntityID entity)
+
+	//Makes sure count more entities can be created without the entity arrays reallocating
+	void ReserveEntities(size_t count)
 	{
-		return data.at(entity);
+		size_t needed = count > freeEntityIndices.size() ? count - freeEntityIndices.size() : 0;
+		size_t capacity = entityVersions.size() + needed;
+		entityVersions.reserve(capacity);
+		entitySignatures.reserve(capacity);
+		entityLocations.reserve(capacity);
 	}
-	std::unordered_map<EntityID, ComponentType>& GetAll() { return data; }
-private:
-	std::unordered_map<EntityID, ComponentType> data;
-};
 
-class Registry
-{
-public:
-	Registry() = default;
-	~Registry() = default;
+	//Hint that count entities in total will own ComponentType, so its storage does not reallocate while they are added
+	template<typename ComponentType>
+	void Reserve(size_t count)
+	{
+		GetStorage<ComponentType>().Reserve(count);
+	}
 
-public:
-	//This returns an unique EntityID
-	EntityID CreateEntity()
+	//Opt-in chunked storage for structurally stable entities (static props, decorations, ...)
+	template<typename... ComponentTypes>
+	EntityID CreateArchetypeEntity(const ComponentTypes&... components)
 	{
-		return nextEntityID++;
+		static_assert(sizeof...(ComponentTypes) > 0, "An archetype entity needs at least one component");
+
+		ComponentSignature signature = MakeSignature<ComponentTypes...>();
+		uint32_t archetypeIndex = GetOrCreateArchetype<ComponentTypes...>(signature);
+		Archetype& archetype = *archetypes[archetypeIndex];
+
+		EntityID entity = CreateEntity();
+		uint32_t index = GetEntityIndex(entity);
+
+		ArchetypeLocation location = archetype.Allocate(entity, archetypeIndex);
+		(archetype.Construct(ComponentFamily::ID<ComponentTypes>(), location, &components), ...);
+
+		entityLocations[index] = location;
+		entitySignatures[index] = signature;
+		return entity;
 	}
 
-	//This removes all components associated with the provided entity
+	//This removes all components associated with the provided entity and frees its index for reuse.
+	//Handles to the removed entity become stale and are ignored from then on
 	void RemoveEntity(EntityID entity)
 	{
-		for (auto& [type, storage] : componentStorages)
+		if (!IsAlive(entity))
+			return;
+
+		uint32_t index = GetEntityIndex(entity);
+
+		if (entityLocations[index].archetype != NoArchetype)
+		{
+			EntityID moved = archetypes[entityLocations[index].archetype]->Remove(entityLocations[index]);
+			if (moved != NullEntity)
+				entityLocations[GetEntityIndex(moved)] = entityLocations[index];
+			entityLocations[index] = ArchetypeLocation{};
+			entitySignatures[index].reset();
+		}
+
+		//Only touch the storages this entity actually populates
+		uint64_t families = entitySignatures[index].to_ullong();
+		while (families != 0)
+		{
+			uint32_t family = static_cast<uint32_t>(std::countr_zero(families));
+			families &= families - 1;
+			componentStorages[family]->Remove(entity);
+		}
+		entitySignatures[index].reset();
+
+		//Wraps after 4096 reuses of the same index
+		entityVersions[index] = (entityVersions[index] + 1) & EntityVersionMask;
+		freeEntityIndices.push_back(index);
+	}
+
+	//False for NullEntity, removed entities and stale handles to a recycled index
+	bool IsAlive(EntityID entity) const
+	{
+		uint32_t index = GetEntityIndex(entity);
+		return index != 0 && index < entityVersions.size() && entityVersions[index] == GetEntityVersion(entity);
+	}
+
+	size_t GetAliveCount() const
+	{
+		return entityVersions.size() - 1 - freeEntityIndices.size();
+	}
+
+	//Bitmask of every component the entity owns, indexed by ComponentFamily ID
+	const ComponentSignature& GetSignature(EntityID entity) const
+	{
+		return entitySignatures[GetEntityIndex(entity)];
+	}
+
+	template<typename... ComponentTypes>
+	ComponentSignature MakeSignature()
+	{
+		ComponentSignature signature;
+		(RegisterComponentType<ComponentTypes>(), ...);
+		(signature.set(ComponentFamily::ID<ComponentTypes>()), ...);
+		return signature;
+	}
+
+	//Calls func(EntityID) for every entity whose signature contains all bits of required, required must not be empty
+	template<typename Func>
+	void EachWithSignature(const ComponentSignature& required, Func&& func)
+	{
+		if (required.none())
+			return;
+
+		for (uint32_t index = 1; index < entitySignatures.size(); ++index)
 		{
-			if (storage->Has(entity))
+			//Freed slots have an empty signature so they never match
+			if ((entitySignatures[index] & required) == required)
 			{
-				storage->Remove(entity);
+				func(MakeEntityID(index, entityVersions[index]));
 			}
 		}
 	}
 
+	//Optional, storages are created on first use. Registering up front fixes the order family IDs are handed out in
 	template<typename ComponentType>
 	void RegisterComponentType()
 	{
-		std::type_index type(typeid(ComponentType));
+		uint32_t family = ComponentFamily::ID<ComponentType>();
+		if (family >= MaxComponentTypes)
+			throw std::runtime_error("Too many component types, raise MaxComponentTypes!");
 
-		if (componentStorages.find(type) == componentStorages.end())
+		if (family >= componentStorages.size())
 		{
-			componentStorages[type] = std::make_unique<ComponentStorage<ComponentType>>();
+			componentStorages.resize(static_cast<size_t>(family) + 1);
+		}
+		if (!componentStorages[family])
+		{
+			componentStorages[family] = std::make_unique<ComponentStorage<ComponentType>>();
+			componentStorages[family]->SetTick(currentTick, ForgetThrough());
 		}
 	}
 
@@ -81,14 +218,17 @@ public:
 	template<typename ComponentType>
 	void SetComponent(EntityID entity, const ComponentType& component)
 	{
-		std::type_index type = std::type_index(typeid(ComponentType));
+		if (!IsAlive(entity))
+			throw std::runtime_error("Cannot add a component to an entity that is not alive!");
 
-		RegisterComponentType<ComponentType>();
+		if (IsArchetypeEntity(entity))
+		{
+			GetArchetypeComponent<ComponentType>(entity) = component;
+			return;
+		}
 
-		auto* storage = static_cast<ComponentStorage<ComponentType>*>(
-			componentStorages.at(type).get()
-		);
-		storage->Set(entity, component);
+		GetStorage<ComponentType>().Set(entity, component);
+		entitySignatures[GetEntityIndex(entity)].set(ComponentFamily::ID<ComponentType>());
 	}
 	
 	//This Adds a default constructed component which then can be modified or replaced
@@ -99,18 +239,20 @@ public:
 		SetComponent<ComponentType>(entity, component);
 	}
 
-	//Removes a component from an entity
+	//Removes a component from an entity, stale handles are ignored
 	template<typename ComponentType>
 	void RemoveComponent(EntityID entity)
 	{
-		std::type_index type = std::type_index(typeid(ComponentType));
+		if (!IsAlive(entity))
+			return;
+		if (IsArchetypeEntity(entity))
+			throw std::runtime_error("Cannot remove a component from an archetype entity!");
 
-		auto* storage = static_cast<ComponentStorage<ComponentType>*>(
-			componentStorages.at(type).get()
-		);
-		if (storage->Has(entity))
+		auto& storage = GetStorage<ComponentType>();
+		if (storage.Has(entity))
 		{
-			storage->Remove(entity);
+			storage.Remove(entity);
+			entitySignatures[GetEntityIndex(entity)].reset(ComponentFamily::ID<ComponentType>());
 		}
 	}
 
@@ -118,30 +260,158 @@ public:
 	template<typename ComponentType>
 	ComponentType& GetComponent(EntityID entity)
 	{
-		std::type_index type = std::type_index(typeid(ComponentType));
-
-		auto* storage = static_cast<ComponentStorage<ComponentType>*>(
-			componentStorages.at(type).get()
-		);
-		if (storage->Has(entity))
+		auto& storage = GetStorage<ComponentType>();
+		if (storage.Has(entity))
+		{
+			return storage.GetUnchecked(entity);
+		}
+		if (IsArchetypeEntity(entity))
 		{
-			return storage->Get(entity);
+			return GetArchetypeComponent<ComponentType>(entity);
 		}
 		throw std::runtime_error("Entity does not have this component!");
 	}
 
+	//Iterates as (EntityID, Component&) pairs, use GetComponents() on the result for the packed array
+	template<typename ComponentType>
+	ComponentStorage<ComponentType>& GetAllComponents()
+	{
+		return GetStorage<ComponentType>().GetAll();
+	}
+
+	//Query over every entity that has all of the listed components, e.g. registry.View<Transform, Visable>().Each(...)
+	template<typename... ComponentTypes>
+	::View<ComponentTypes...> View()
+	{
+		ComponentSignature required = MakeSignature<ComponentTypes...>();
+		return ::View<ComponentTypes...>(entitySignatures, required, GetStorage<ComponentTypes>()...);
+	}
+
+	/*
+	Streams every archetype chunk containing all of the listed components.
+	func is called once per chunk as func(uint32_t count, const EntityID* entities, ComponentTypes*... columns).
+	Only covers archetype entities, sparse set entities are reached through View.
+	*/
+	template<typename... ComponentTypes, typename Func>
+	void EachChunk(Func&& func)
+	{
+		ComponentSignature required = MakeSignature<ComponentTypes...>();
+		for (auto& archetype : archetypes)
+		{
+			if ((archetype->GetSignature() & required) != required)
+				continue;
+
+			for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+			{
+				func(archetype->GetChunkEntityCount(chunk), archetype->GetEntities(chunk), archetype->template GetColumn<ComponentTypes>(chunk)...);
+			}
+		}
+	}
+
+	//Entities whose ComponentType was set or marked changed after sinceTick, e.g. registry.Changed<Transform>(lastRunTick).Each(...)
 	template<typename ComponentType>
-	std::unordered_map<EntityID, ComponentType>& GetAllComponents()
+	ChangedView<ComponentType> Changed(ChangeTick sinceTick)
 	{
-		std::type_index type = std::type_index(typeid(ComponentType));
-		auto* storage = static_cast<ComponentStorage<ComponentType>*>(
-			componentStorages.at(type).get()
-		);
+		return ChangedView<ComponentType>(GetStorage<ComponentType>(), sinceTick);
+	}
 
-		return storage->GetAll();
+	//Call after writing to a component through a reference so Changed picks it up
+	template<typename ComponentType>
+	void MarkChanged(EntityID entity)
+	{
+		GetStorage<ComponentType>().MarkChanged(entity);
+	}
+
+	//GetComponent that also marks the component as changed
+	template<typename ComponentType>
+	ComponentType& Patch(EntityID entity)
+	{
+		ComponentType& component = GetComponent<ComponentType>(entity);
+		MarkChanged<ComponentType>(entity);
+		return component;
+	}
+
+	//Changes are stamped with the current tick, a system remembers GetTick() and asks for Changed since then on its next run
+	ChangeTick GetTick() const { return currentTick; }
+
+	//Starts a new tick, called once per frame through WorldController::BeginFrame. Systems read Changed since the last tick they saw
+	void AdvanceTick()
+	{
+		++currentTick;
+		for (auto& storage : componentStorages)
+		{
+			if (storage)
+				storage->SetTick(currentTick, ForgetThrough());
+		}
+	}
+
+	//How many ticks of change log are kept, Changed further back than this scans the whole storage instead
+	void SetChangeHistory(ChangeTick ticks) { changeHistoryTicks = std::max<ChangeTick>(ticks, 1); }
+
+	//False for stale handles, their index may belong to a different entity by now
+	bool IsArchetypeEntity(EntityID entity) const
+	{
+		return IsAlive(entity) && entityLocations[GetEntityIndex(entity)].archetype != NoArchetype;
 	}
 private:
-	EntityID nextEntityID = 1;
-	std::unordered_map<std::type_index, std::unique_ptr<ComponentStorageI>> componentStorages;
+	ChangeTick ForgetThrough() const
+	{
+		return currentTick > changeHistoryTicks ? currentTick - changeHistoryTicks : 0;
+	}
+
+	template<typename... ComponentTypes>
+	uint32_t GetOrCreateArchetype(const ComponentSignature& signature)
+	{
+		auto it = archetypeLookup.find(signature.to_ullong());
+		if (it != archetypeLookup.end())
+			return it->second;
+
+		uint32_t archetypeIndex = static_cast<uint32_t>(archetypes.size());
+		archetypes.push_back(std::make_unique<Archetype>(signature, std::vector<ComponentTypeInfo>{ ComponentTypeInfo::Of<ComponentTypes>()... }));
+		archetypeLookup.insert({ signature.to_ullong(), archetypeIndex });
+		return archetypeIndex;
+	}
 
-};
\ No newline at end of file
+	template<typename ComponentType>
+	ComponentType& GetArchetypeComponent(EntityID entity)
+	{
+		uint32_t family = ComponentFamily::ID<ComponentType>();
+		const ArchetypeLocation& location = entityLocations[GetEntityIndex(entity)];
+		Archetype& archetype = *archetypes[location.archetype];
+		if (!archetype.HasFamily(family))
+			throw std::runtime_error("Archetype entities cannot gain new components!");
+		return *static_cast<ComponentType*>(archetype.GetComponent(family, location));
+	}
+
+	//One array index on the hot path, the storage is only created the first time a type is used
+	template<typename ComponentType>
+	ComponentStorage<ComponentType>& GetStorage()
+	{
+		uint32_t family = ComponentFamily::ID<ComponentType>();
+		if (family >= componentStorages.size() || !componentStorages[family])
+		{
+			RegisterComponentType<ComponentType>();
+		}
+		return *static_cast<ComponentStorage<ComponentType>*>(componentStorages[family].get());
+	}
+private:
+	//Indexed by entity index, slot 0 is reserved so NullEntity is never alive
+	std::vector<uint32_t> entityVersions{ 0 };
+	//Parallel to entityVersions
+	std::vector<ComponentSignature> entitySignatures{ ComponentSignature{} };
+	//Parallel to entityVersions, archetype is NoArchetype for sparse set entities
+	std::vector<ArchetypeLocation> entityLocations{ ArchetypeLocation{} };
+	//Popped from the back so recently freed (still cached) slots are reused first
+	std::vector<uint32_t> freeEntityIndices;
+	//Indexed by ComponentFamily::ID<ComponentType>()
+	std::vector<std::unique_ptr<ComponentStorageI>> componentStorages;
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	//Signature bits to index into archetypes
+	std::unordered_map<uint64_t, uint32_t> archetypeLookup;
+
+	//Tick 0 is "never changed", so every change is newer than a system that has not run yet
+	ChangeTick currentTick = 1;
+	ChangeTick changeHistoryTicks = 8;
+
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include <tuple>
+#include <vector>
+
+#include "ComponentStorage.h"
+#include "Jobs/JobSystem.h"
+
+/*
+A query over every entity that owns all of the listed components.
+Iteration is driven by the smallest storage and membership is checked against the entity's component signature,
+so there is no type lookup, hashing or virtual call per entity. Do not add or remove components while iterating.
+*/
+template<typename... ComponentTypes>
+class View
+{
+	static_assert(sizeof...(ComponentTypes) > 0, "A View needs at least one component type");
+public:
+	View(const std::vector<ComponentSignature>& entitySignatures, ComponentSignature required, ComponentStorage<ComponentTypes>&... componentStorages)
+		: storages(&componentStorages...), signatures(&entitySignatures), requiredSignature(required)
+	{
+		const std::vector<EntityID>* candidates[] = { &componentStorages.GetEntities()... };
+		drivingEntities = candidates[0];
+		for (const std::vector<EntityID>* candidate : candidates)
+		{
+			if (candidate->size() < drivingEntities->size())
+				drivingEntities = candidate;
+		}
+	}
+
+	//func is called as func(EntityID, ComponentTypes&...)
+	template<typename Func>
+	void Each(Func&& func)
+	{
+		const std::vector<EntityID>& entities = *drivingEntities;
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			EntityID entity = entities[i];
+			if (((*signatures)[GetEntityIndex(entity)] & requiredSignature) != requiredSignature)
+				continue;
+
+			func(entity, Fetch<ComponentTypes>(entity, i)...);
+		}
+	}
+
+	/*
+	Same as Each but the driving range is split into chunks of grainSize entities that run across the job system.
+	func is called concurrently for different entities, so it must only touch the components it is handed.
+	*/
+	template<typename Func>
+	void ParallelEach(JobSystem& jobSystem, Func&& func, size_t grainSize = 1024)
+	{
+		const std::vector<EntityID>& entities = *drivingEntities;
+		jobSystem.ParallelFor(entities.size(), grainSize, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				EntityID entity = entities[i];
+				if (((*signatures)[GetEntityIndex(entity)] & requiredSignature) != requiredSignature)
+					continue;
+
+				func(entity, Fetch<ComponentTypes>(entity, i)...);
+			}
+		});
+	}
+
+	//Upper bound on the number of entities Each will visit
+	size_t SizeHint() const { return drivingEntities->size(); }
+
+private:
+	template<typename ComponentType>
+	ComponentType& Fetch(EntityID entity, size_t drivingIndex)
+	{
+		ComponentStorage<ComponentType>* storage = std::get<ComponentStorage<ComponentType>*>(storages);
+		//The driving storage is walked in order, so its slot is the loop index
+		if (&storage->GetEntities() == drivingEntities)
+			return storage->GetComponents()[drivingIndex];
+		return storage->GetUnchecked(entity);
+	}
+
+private:
+	std::tuple<ComponentStorage<ComponentTypes>*...> storages;
+	const std::vector<EntityID>* drivingEntities = nullptr;
+	const std::vector<ComponentSignature>* signatures = nullptr;
+	ComponentSignature requiredSignature;
+};
+
+/*
+Every entity whose ComponentType changed after sinceTick, each visited once.
+Walks the storage's change log when it still reaches back to sinceTick, otherwise falls back to scanning the change tick of every slot.
+Only covers sparse set storage, archetype entities are not change tracked.
+func must not change the storage being walked: no MarkChanged, Patch or SetComponent of ComponentType from inside Each
+or ParallelEach, debug builds assert on it. Collect the entities and write to them once the walk has returned.
+*/
+template<typename ComponentType>
+class ChangedView
+{
+public:
+	ChangedView(ComponentStorage<ComponentType>& storage, ChangeTick sinceTick)
+		: storage(&storage), sinceTick(sinceTick), useLog(storage.HasChangeHistorySince(sinceTick))
+	{
+		first = useLog ? storage.FirstChangeSince(sinceTick) : 0;
+	}
+
+	//func is called as func(EntityID, ComponentType&)
+	template<typename Func>
+	void Each(Func&& func)
+	{
+		ReadScope scope(*storage);
+		Visit(0, SizeHint(), func);
+	}
+
+	//func runs concurrently for different entities, see View::ParallelEach
+	template<typename Func>
+	void ParallelEach(JobSystem& jobSystem, Func&& func, size_t grainSize = 1024)
+	{
+		ReadScope scope(*storage);
+		jobSystem.ParallelFor(SizeHint(), grainSize, [&](size_t begin, size_t end) { Visit(begin, end, func); });
+	}
+
+	//Upper bound on the number of entities Each will visit
+	size_t SizeHint() const
+	{
+		return useLog ? storage->GetChangeLog().size() - first : storage->size();
+	}
+
+private:
+	struct ReadScope
+	{
+		ComponentStorage<ComponentType>& storage;
+		explicit ReadScope(ComponentStorage<ComponentType>& storage) : storage(storage) { storage.BeginChangeRead(); }
+		~ReadScope() { storage.EndChangeRead(); }
+	};
+
+	template<typename Func>
+	void Visit(size_t begin, size_t end, Func& func)
+	{
+		if (useLog)
+		{
+			auto changeLog = storage->GetChangeLog();
+			for (size_t i = first + begin; i < first + end; ++i)
+			{
+				if (storage->IsLatestChange(changeLog[i]))
+					func(changeLog[i].entity, storage->GetUnchecked(changeLog[i].entity));
+			}
+			return;
+		}
+
+		const std::vector<ChangeTick>& changeTicks = storage->GetChangeTicks();
+		const std::vector<EntityID>& entities = storage->GetEntities();
+		std::vector<ComponentType>& components = storage->GetComponents();
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (changeTicks[i] > sinceTick)
+				func(entities[i], components[i]);
+		}
+	}
+
+private:
+	ComponentStorage<ComponentType>* storage;
+	ChangeTick sinceTick;
+	bool useLog;
+	size_t first = 0;
+};
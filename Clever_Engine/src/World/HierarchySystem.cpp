@@ -0,0 +1,204 @@
+#include "HierarchySystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void HierarchySystem::SetParent(Registry& registry, EntityID child, EntityID parent)
+{
+	if (!registry.IsAlive(child) || !registry.IsAlive(parent))
+		throw std::runtime_error("Cannot parent entities that are not alive!");
+	if (child == parent || IsAncestor(registry, child, parent))
+		throw std::runtime_error("Parenting would create a cycle in the hierarchy!");
+
+	RemoveParent(registry, child);
+
+	if (!registry.GetSignature(child).test(ComponentFamily::ID<Transform>()))
+		registry.AddComponent<Transform>(child);
+	if (!registry.GetSignature(parent).test(ComponentFamily::ID<Transform>()))
+		registry.AddComponent<Transform>(parent);
+	if (!registry.GetSignature(parent).test(ComponentFamily::ID<Children>()))
+		registry.AddComponent<Children>(parent);
+
+	registry.SetComponent(child, Parent{ parent });
+	registry.GetComponent<Children>(parent).entities.push_back(child);
+	orderDirty = true;
+}
+
+void HierarchySystem::RemoveParent(Registry& registry, EntityID child)
+{
+	if (!registry.IsAlive(child) || !registry.GetSignature(child).test(ComponentFamily::ID<Parent>()))
+		return;
+
+	EntityID parent = registry.GetComponent<Parent>(child).entity;
+	if (registry.IsAlive(parent) && registry.GetSignature(parent).test(ComponentFamily::ID<Children>()))
+	{
+		std::vector<EntityID>& siblings = registry.GetComponent<Children>(parent).entities;
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), child), siblings.end());
+	}
+
+	registry.RemoveComponent<Parent>(child);
+	//Now relative to the world, so its subtree needs propagating even if nothing else changed
+	registry.MarkChanged<Transform>(child);
+	orderDirty = true;
+}
+
+void HierarchySystem::Update(Registry& registry, ChangeTick sinceTick)
+{
+	ComponentStorage<Transform>& transforms = registry.GetAllComponents<Transform>();
+	ComponentStorage<Visable>& visables = registry.GetAllComponents<Visable>();
+
+	//Entities removed or components moved around since the last Update invalidate the cached order
+	if (!orderDirty)
+	{
+		bool sorted = true;
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			//A member that lost its Transform also shortened the storage, so stop before comparing past its end
+			if (!registry.IsAlive(order[i]) || !transforms.Has(order[i]))
+			{
+				orderDirty = true;
+				break;
+			}
+			sorted = sorted && i < transforms.size() && transforms.GetEntities()[i] == order[i];
+		}
+		if (!orderDirty && !sorted)
+			transforms.Reorder(order);
+	}
+
+	if (orderDirty)
+	{
+		//Entities leaving the hierarchy fall back to their local matrix, the ones staying get their world matrix below
+		for (EntityID entity : order)
+		{
+			if (transforms.Has(entity) && visables.Has(entity))
+			{
+				visables.GetUnchecked(entity).matrix = transforms.GetUnchecked(entity).modelMatrix;
+				visables.MarkChanged(entity);
+			}
+		}
+
+		Rebuild(registry);
+		transforms.Reorder(order);
+		dirty.assign(order.size(), 1);
+		orderDirty = false;
+	}
+	else
+	{
+		//A changed entity dirties its whole subtree, which is the contiguous range up to subtreeEnds
+		dirty.assign(order.size(), 0);
+		const std::vector<ChangeTick>& changeTicks = transforms.GetChangeTicks();
+		uint32_t i = 0;
+		while (i < order.size())
+		{
+			if (changeTicks[i] > sinceTick)
+			{
+				std::fill(dirty.begin() + i, dirty.begin() + subtreeEnds[i], uint8_t(1));
+				i = subtreeEnds[i];
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	std::vector<Transform>& locals = transforms.GetComponents();
+	worldMatrices.resize(order.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		if (!dirty[i])
+			continue;
+
+		//Parents come first, so their world matrix is already final
+		worldMatrices[i] = parentIndices[i] == NoParent
+			? locals[i].modelMatrix
+			: worldMatrices[parentIndices[i]] * locals[i].modelMatrix;
+
+		if (visables.Has(order[i]))
+		{
+			visables.GetUnchecked(order[i]).matrix = worldMatrices[i];
+			visables.MarkChanged(order[i]);
+		}
+	}
+}
+
+void HierarchySystem::Rebuild(Registry& registry)
+{
+	order.clear();
+	parentIndices.clear();
+	subtreeEnds.clear();
+
+	ComponentStorage<Parent>& parents = registry.GetAllComponents<Parent>();
+	ComponentStorage<Children>& childLists = registry.GetAllComponents<Children>();
+
+	//Children removed without being detached are dropped here, otherwise every Rebuild walks past them again
+	for (auto [entity, children] : childLists)
+		std::erase_if(children.entities, [&](EntityID child) { return !registry.IsAlive(child); });
+
+	auto isRoot = [&](EntityID entity)
+	{
+		return !parents.Has(entity) || !registry.IsAlive(parents.GetUnchecked(entity).entity);
+	};
+	//Entities that lost their Transform drop out of the hierarchy along with their subtree
+	ComponentStorage<Transform>& transforms = registry.GetAllComponents<Transform>();
+	auto isPlaced = [&](EntityID entity)
+	{
+		return registry.IsAlive(entity) && transforms.Has(entity);
+	};
+
+	for (auto [root, rootChildren] : childLists)
+	{
+		if (!isRoot(root) || !transforms.Has(root))
+			continue;
+
+		//Depth first with an explicit stack, subtreeEnds is filled in once all of an entry's descendants are placed
+		uint32_t rootIndex = static_cast<uint32_t>(order.size());
+		order.push_back(root);
+		parentIndices.push_back(NoParent);
+		subtreeEnds.push_back(0);
+
+		stack.clear();
+		stack.push_back(rootIndex);
+		nextChild.clear();
+		nextChild.push_back(0);
+		while (!stack.empty())
+		{
+			uint32_t current = stack.back();
+			EntityID entity = order[current];
+			const std::vector<EntityID>* children = childLists.Has(entity) ? &childLists.GetUnchecked(entity).entities : nullptr;
+
+			//Skip children that lost their Transform
+			uint32_t& next = nextChild.back();
+			while (children && next < children->size() && !isPlaced((*children)[next]))
+				++next;
+
+			if (!children || next >= children->size())
+			{
+				subtreeEnds[current] = static_cast<uint32_t>(order.size());
+				stack.pop_back();
+				nextChild.pop_back();
+				continue;
+			}
+
+			EntityID child = (*children)[next++];
+			uint32_t childIndex = static_cast<uint32_t>(order.size());
+			order.push_back(child);
+			parentIndices.push_back(current);
+			subtreeEnds.push_back(0);
+			stack.push_back(childIndex);
+			nextChild.push_back(0);
+		}
+	}
+}
+
+bool HierarchySystem::IsAncestor(Registry& registry, EntityID ancestor, EntityID entity)
+{
+	ComponentStorage<Parent>& parents = registry.GetAllComponents<Parent>();
+	while (parents.Has(entity))
+	{
+		entity = parents.GetUnchecked(entity).entity;
+		if (entity == ancestor)
+			return true;
+	}
+	return false;
+}
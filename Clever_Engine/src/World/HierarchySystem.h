@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm.hpp>
+
+#include "ECS/Registry.h"
+#include "ECS/Components.h"
+
+/*
+Parent/child transforms. Every entity in a hierarchy is laid out depth first, parents before children,
+and the Transform storage is kept in that same order so propagating world matrices is one linear pass.
+Depth first also makes every subtree a contiguous range, so a changed Transform only re-propagates its own range.
+The world matrix of a hierarchy entity ends up in its Visable matrix.
+*/
+class HierarchySystem
+{
+public:
+	HierarchySystem() = default;
+	~HierarchySystem() = default;
+
+public:
+	//Makes child follow parent, both get a Transform if they do not have one. Throws if this would create a cycle
+	void SetParent(Registry& registry, EntityID child, EntityID parent);
+	//Detaches child, its Transform becomes relative to the world again
+	void RemoveParent(Registry& registry, EntityID child);
+
+	//Call after local model matrices are up to date, propagates every subtree with a Transform changed after sinceTick
+	void Update(Registry& registry, ChangeTick sinceTick);
+
+	const std::vector<EntityID>& GetOrder() const { return order; }
+
+private:
+	void Rebuild(Registry& registry);
+	bool IsAncestor(Registry& registry, EntityID ancestor, EntityID entity);
+
+private:
+	//Depth first, parents before children
+	std::vector<EntityID> order;
+	//Parallel to order, index of the parent in order or NoParent for roots
+	std::vector<uint32_t> parentIndices;
+	//Parallel to order, one past the last descendant
+	std::vector<uint32_t> subtreeEnds;
+	//Parallel to order
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<uint8_t> dirty;
+
+	//Scratch for Rebuild, indices into order and the next child to visit for each
+	std::vector<uint32_t> stack;
+	std::vector<uint32_t> nextChild;
+	bool orderDirty = false;
+
+	static constexpr uint32_t NoParent = UINT32_MAX;
+};
@@ -0,0 +1,243 @@
+#include "TransformKernel.h"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef CLEVER_TRANSFORM_X64
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define CLEVER_TARGET_AVX2
+	#else
+		#define CLEVER_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+void TransformSoA::Clear()
+{
+	for (std::vector<float>* column : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ })
+		column->clear();
+}
+
+void TransformSoA::Reserve(size_t count)
+{
+	for (std::vector<float>* column : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ })
+		column->reserve(count);
+}
+
+void TransformSoA::PushBack(const Transform& transform)
+{
+	positionX.push_back(transform.position.x);
+	positionY.push_back(transform.position.y);
+	positionZ.push_back(transform.position.z);
+	rotationX.push_back(transform.rotation.x);
+	rotationY.push_back(transform.rotation.y);
+	rotationZ.push_back(transform.rotation.z);
+	rotationW.push_back(transform.rotation.w);
+	scaleX.push_back(transform.scale.x);
+	scaleY.push_back(transform.scale.y);
+	scaleZ.push_back(transform.scale.z);
+}
+
+void ComposeModelMatricesScalar(const TransformSoA& batch, size_t begin, size_t end, glm::mat4* out)
+{
+	for (size_t i = begin; i < end; ++i)
+	{
+		float qx = batch.rotationX[i], qy = batch.rotationY[i], qz = batch.rotationZ[i], qw = batch.rotationW[i];
+		float x2 = qx + qx, y2 = qy + qy, z2 = qz + qz;
+		float xx = qx * x2, yy = qy * y2, zz = qz * z2;
+		float xy = qx * y2, xz = qx * z2, yz = qy * z2;
+		float wx = qw * x2, wy = qw * y2, wz = qw * z2;
+		float sx = batch.scaleX[i], sy = batch.scaleY[i], sz = batch.scaleZ[i];
+
+		glm::mat4& m = out[i];
+		m[0] = glm::vec4((1.0f - (yy + zz)) * sx, (xy + wz) * sx, (xz - wy) * sx, 0.0f);
+		m[1] = glm::vec4((xy - wz) * sy, (1.0f - (xx + zz)) * sy, (yz + wx) * sy, 0.0f);
+		m[2] = glm::vec4((xz + wy) * sz, (yz - wx) * sz, (1.0f - (xx + yy)) * sz, 0.0f);
+		m[3] = glm::vec4(batch.positionX[i], batch.positionY[i], batch.positionZ[i], 1.0f);
+	}
+}
+
+#ifdef CLEVER_TRANSFORM_X64
+
+namespace
+{
+	//Turns 4 lanes-of-x/y/z/w registers into column c of 4 consecutive matrices
+	inline void StoreColumnSSE(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* out, int column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&out[0][column][0], x);
+		_mm_storeu_ps(&out[1][column][0], y);
+		_mm_storeu_ps(&out[2][column][0], z);
+		_mm_storeu_ps(&out[3][column][0], w);
+	}
+
+	size_t ComposeSSE(const TransformSoA& batch, size_t count, glm::mat4* out)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 qx = _mm_loadu_ps(&batch.rotationX[i]), qy = _mm_loadu_ps(&batch.rotationY[i]);
+			__m128 qz = _mm_loadu_ps(&batch.rotationZ[i]), qw = _mm_loadu_ps(&batch.rotationW[i]);
+			__m128 x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+			__m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+			__m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+			__m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+			__m128 sx = _mm_loadu_ps(&batch.scaleX[i]), sy = _mm_loadu_ps(&batch.scaleY[i]), sz = _mm_loadu_ps(&batch.scaleZ[i]);
+
+			StoreColumnSSE(
+				_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+				_mm_mul_ps(_mm_add_ps(xy, wz), sx),
+				_mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+				zero, out + i, 0);
+			StoreColumnSSE(
+				_mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+				_mm_mul_ps(_mm_add_ps(yz, wx), sy),
+				zero, out + i, 1);
+			StoreColumnSSE(
+				_mm_mul_ps(_mm_add_ps(xz, wy), sz),
+				_mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+				zero, out + i, 2);
+			StoreColumnSSE(
+				_mm_loadu_ps(&batch.positionX[i]),
+				_mm_loadu_ps(&batch.positionY[i]),
+				_mm_loadu_ps(&batch.positionZ[i]),
+				one, out + i, 3);
+		}
+		return i;
+	}
+
+	//Same as StoreColumnSSE for 8 matrices, each 128 bit half transposes on its own
+	CLEVER_TARGET_AVX2 inline void StoreColumnAVX2(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* out, int column)
+	{
+		__m256 t0 = _mm256_unpacklo_ps(x, y);
+		__m256 t1 = _mm256_unpackhi_ps(x, y);
+		__m256 t2 = _mm256_unpacklo_ps(z, w);
+		__m256 t3 = _mm256_unpackhi_ps(z, w);
+		__m256 r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+		__m256 r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+		__m256 r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+		__m256 r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+
+		_mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(r0));
+		_mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(r1));
+		_mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(r2));
+		_mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(r3));
+		_mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(r0, 1));
+		_mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(r1, 1));
+		_mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(r2, 1));
+		_mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(r3, 1));
+	}
+
+	CLEVER_TARGET_AVX2 size_t ComposeAVX2(const TransformSoA& batch, size_t count, glm::mat4* out)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 qx = _mm256_loadu_ps(&batch.rotationX[i]), qy = _mm256_loadu_ps(&batch.rotationY[i]);
+			__m256 qz = _mm256_loadu_ps(&batch.rotationZ[i]), qw = _mm256_loadu_ps(&batch.rotationW[i]);
+			__m256 x2 = _mm256_add_ps(qx, qx), y2 = _mm256_add_ps(qy, qy), z2 = _mm256_add_ps(qz, qz);
+			__m256 xx = _mm256_mul_ps(qx, x2), yy = _mm256_mul_ps(qy, y2), zz = _mm256_mul_ps(qz, z2);
+			__m256 xy = _mm256_mul_ps(qx, y2), xz = _mm256_mul_ps(qx, z2), yz = _mm256_mul_ps(qy, z2);
+			__m256 wx = _mm256_mul_ps(qw, x2), wy = _mm256_mul_ps(qw, y2), wz = _mm256_mul_ps(qw, z2);
+			__m256 sx = _mm256_loadu_ps(&batch.scaleX[i]), sy = _mm256_loadu_ps(&batch.scaleY[i]), sz = _mm256_loadu_ps(&batch.scaleZ[i]);
+
+			StoreColumnAVX2(
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+				_mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+				_mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+				zero, out + i, 0);
+			StoreColumnAVX2(
+				_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+				_mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+				zero, out + i, 1);
+			StoreColumnAVX2(
+				_mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+				_mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+				zero, out + i, 2);
+			StoreColumnAVX2(
+				_mm256_loadu_ps(&batch.positionX[i]),
+				_mm256_loadu_ps(&batch.positionY[i]),
+				_mm256_loadu_ps(&batch.positionZ[i]),
+				one, out + i, 3);
+		}
+		return i;
+	}
+}
+
+bool CpuSupportsAVX2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	//OSXSAVE and AVX, then check the OS saves the YMM registers
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+void ComposeModelMatricesSSE(const TransformSoA& batch, glm::mat4* out)
+{
+	size_t count = batch.size();
+	ComposeModelMatricesScalar(batch, ComposeSSE(batch, count, out), count, out);
+}
+
+void ComposeModelMatricesAVX2(const TransformSoA& batch, glm::mat4* out)
+{
+	size_t count = batch.size();
+	ComposeModelMatricesScalar(batch, ComposeAVX2(batch, count, out), count, out);
+}
+
+void ComposeModelMatrices(const TransformSoA& batch, glm::mat4* out)
+{
+	static const bool hasAVX2 = CpuSupportsAVX2();
+
+	if (hasAVX2)
+		ComposeModelMatricesAVX2(batch, out);
+	else
+		ComposeModelMatricesSSE(batch, out);
+}
+
+#else
+
+void ComposeModelMatrices(const TransformSoA& batch, glm::mat4* out)
+{
+	ComposeModelMatricesScalar(batch, 0, batch.size(), out);
+}
+
+#endif
+
+bool MatchesGlmModelMatrix(const Transform& transform, const glm::mat4& composed, float epsilon)
+{
+	Transform reference = transform;
+	reference.UpdateModelMatrix();
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			float expected = reference.modelMatrix[column][row];
+			if (std::abs(expected - composed[column][row]) > epsilon * std::max(1.0f, std::abs(expected)))
+				return false;
+		}
+	}
+	return true;
+}
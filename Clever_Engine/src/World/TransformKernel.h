@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm.hpp>
+
+#include "Objects/Vertex.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+	#define CLEVER_TRANSFORM_X64 1
+#endif
+
+/*
+Structure of arrays copy of a batch of Transforms, the layout the batched model matrix kernel reads.
+Gather the transforms a system wants to update, compose them in one call, then write the matrices back.
+*/
+struct TransformSoA
+{
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+
+	void Clear();
+	void Reserve(size_t count);
+	void PushBack(const Transform& transform);
+	size_t size() const { return positionX.size(); }
+};
+
+/*
+Writes Translation * Rotation * Scale for every transform in the batch to out, which must hold batch.size() matrices.
+The matrix is built directly from the quaternion and scale instead of multiplying three mat4s,
+8 transforms at a time with AVX2 or 4 with SSE, picked once at runtime. The rotation must be a unit quaternion.
+*/
+void ComposeModelMatrices(const TransformSoA& batch, glm::mat4* out);
+
+//Plain C++ version of ComposeModelMatrices, also used for the tail that does not fill a SIMD register
+void ComposeModelMatricesScalar(const TransformSoA& batch, size_t begin, size_t end, glm::mat4* out);
+
+#ifdef CLEVER_TRANSFORM_X64
+//The paths ComposeModelMatrices picks between, each composes the whole batch tail included. Exposed so tests can check both on one machine
+void ComposeModelMatricesSSE(const TransformSoA& batch, glm::mat4* out);
+//Only call when CpuSupportsAVX2
+void ComposeModelMatricesAVX2(const TransformSoA& batch, glm::mat4* out);
+bool CpuSupportsAVX2();
+#endif
+
+//Compares a composed matrix against Transform::UpdateModelMatrix with a relative tolerance, for debug checks of the SIMD paths
+bool MatchesGlmModelMatrix(const Transform& transform, const glm::mat4& composed, float epsilon = 1e-4f);
@@ -1,23 +1,51 @@
 #include "WorldController.h"
 
 #include "ECS/Components.h"
+#include "TransformKernel.h"
 #include <glm.hpp>
+#include <cassert>
 
 void WorldController::Init()
 {
 }
-void WorldController::Update()
+void WorldController::Update(JobSystem& jobSystem)
 {
-	auto& visableComponents = registry.GetAllComponents<Visable>();
-	for (auto& [entityID, visableComponent] : visableComponents)
+	//BeginFrame already started this frame's tick, so the changes made before Update this frame are read too
+	ChangeTick sinceTick = lastUpdateTick;
+	lastUpdateTick = registry.GetTick();
+
+	changedEntities.clear();
+	registry.Changed<Transform>(sinceTick).Each([this](EntityID entityID, Transform&) { changedEntities.push_back(entityID); });
+
+	ComponentStorage<Transform>& transforms = registry.GetAllComponents<Transform>();
+	ComponentStorage<Visable>& visables = registry.GetAllComponents<Visable>();
+	jobSystem.ParallelFor(changedEntities.size(), 1024, [&](size_t begin, size_t end)
 	{
-		if(visableComponent.isDirty)
+		//Scratch kept per thread so steady state batches do not allocate
+		thread_local TransformSoA batch;
+		thread_local std::vector<glm::mat4> matrices;
+
+		batch.Clear();
+		for (size_t i = begin; i < end; ++i)
+			batch.PushBack(transforms.GetUnchecked(changedEntities[i]));
+		matrices.resize(end - begin);
+		ComposeModelMatrices(batch, matrices.data());
+
+		assert(MatchesGlmModelMatrix(transforms.GetUnchecked(changedEntities[begin]), matrices[0]) && "SIMD model matrix does not match glm");
+
+		for (size_t i = begin; i < end; ++i)
 		{
-			auto& transformComponent = registry.GetComponent<Transform>(entityID);
-			// Update the matrix based on the transform
-			// (This is a placeholder; actual matrix calculation would go here)
-			visableComponent.matrix = glm::mat4(1.0f); // Identity matrix
-			visableComponent.isDirty = false;
+			EntityID entityID = changedEntities[i];
+			const glm::mat4& matrix = matrices[i - begin];
+			transforms.GetUnchecked(entityID).modelMatrix = matrix;
+			if (visables.Has(entityID))
+			{
+				visables.GetUnchecked(entityID).matrix = matrix;
+				visables.MarkChanged(entityID);
+			}
 		}
-	}
-}
\ No newline at end of file
+	});
+
+	//Local matrices are final now, parented entities replace their Visable matrix with the world matrix
+	hierarchy.Update(registry, sinceTick);
+}
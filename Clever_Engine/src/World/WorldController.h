@@ -1,6 +1,9 @@
 #pragma once
 #include "ECS/Registry.h"
+#include "ECS/EntityCommandBuffer.h"
 #include "ECS/Components.h"
+#include "HierarchySystem.h"
+#include "Jobs/JobSystem.h"
 #include <random>
 
 class WorldController
@@ -10,11 +13,17 @@ public:
 	~WorldController() = default;
 
 	void Init();
-	void Update();
-
+	//Starts the frame's change tick, call once per frame before anything writes components.
+	//Transforms are written before Update in the frame, later writes share the tick Update has already consumed
+	void BeginFrame() { registry.AdvanceTick(); }
+	void Update(JobSystem& jobSystem);
+	//Sync point, applies every structural change recorded since the last call
+	void FlushCommands() { commandBuffer.Playback(registry); }
+
+	//Recorded into the command buffer, the entity exists after the next FlushCommands
 	void AddTriangle()
 	{
-		auto entity = registry.CreateEntity();
+		auto entity = commandBuffer.CreateEntity();
 
 		std::random_device rd;
 		std::mt19937 gen(rd());
@@ -26,12 +35,23 @@ public:
 		transform.scale = glm::vec3(1.0f, 1.0f, 1.0f);
 		transform.rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
-		registry.AddComponent<Transform>(entity);
-		registry.AddComponent<Visable>(entity);
+		commandBuffer.AddComponent(entity, transform);
+		commandBuffer.AddComponent(entity, Visable{});
 	}
 
+	//child's Transform becomes relative to parent, see HierarchySystem
+	void SetParent(EntityID child, EntityID parent) { hierarchy.SetParent(registry, child, parent); }
+	void RemoveParent(EntityID child) { hierarchy.RemoveParent(registry, child); }
+
 	Registry& GetRegistry() { return registry; }
+	EntityCommandBuffer& GetCommandBuffer() { return commandBuffer; }
 
 private:
 	Registry registry{};
+	EntityCommandBuffer commandBuffer{};
+	HierarchySystem hierarchy{};
+	//Last tick whose changes Update has consumed
+	ChangeTick lastUpdateTick = 0;
+	//Reused every Update, entities whose Transform changed since lastUpdateTick
+	std::vector<EntityID> changedEntities;
 };
\ No newline at end of file
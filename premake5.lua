@@ -26,4 +26,5 @@ outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 include "Clever_Engine/Vulkan" 
 include "Clever_Engine"
+include "Clever_Engine/Tests"
 include "SpellGame"
\ No newline at end of file